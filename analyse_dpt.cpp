@@ -1,167 +1,26 @@
 #include <algorithm>
 #include "analyse_dpt.hpp"
 #include <array>
+#include <chrono>
+#include "dpt_definitions.hpp"
+#include "dpt_post_memo.hpp"
 #include "dpt_thread_statistics.hpp"
-#include <map>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include "search_toolbox.hpp"
 #include <string>
 #include "string_toolbox.hpp"
 #include <string_view>
+#include <system_error>
+#include <thread>
 #include <utility>
 #include <vector>
 
 namespace {
-enum search_policy {
-    policy_no_transform     = 1 << 0,
-    policy_lowercase        = 1 << 1,
-    policy_no_punctuation   = 1 << 2,
-    policy_simple_count     = 1 << 3,
-    policy_count_helper     = 1 << 4,
-    policy_exact_match      = 1 << 5,
-    policy_unique           = 1 << 6,
-    policy_count_all        = 1 << 7
-};
-int policy_standard       = (policy_lowercase | policy_simple_count | policy_unique);
-int policy_case_sensitive = (policy_no_punctuation | policy_count_helper | policy_unique);
-int policy_substring_risk = (policy_lowercase | policy_no_punctuation | policy_count_helper | policy_unique);
-int policy_single_letter  = (policy_no_transform | policy_count_helper | policy_unique);
-int policy_sentence       = (policy_lowercase | policy_no_punctuation | policy_simple_count | policy_unique);
-int policy_single_word    = (policy_lowercase | policy_no_punctuation | policy_exact_match | policy_unique);
-
-struct search_value {
-    search_value(std::string_view key, const std::vector<std::string>& tokens, int policies, const std::vector<std::string>& occurs_in)
-    : key{key}, tokens{tokens}, policies{policies}, occurs_in{occurs_in} {}
-    search_value(std::string_view key, const std::vector<std::string>& tokens, int policies)
-    : search_value{key, tokens, policies, {}} {}
-
-    const std::string key;
-    const std::vector<std::string> tokens;
-    const int policies;
-    const std::vector<std::string> occurs_in;
-};
-using search_values = std::vector<search_value>;
-
-namespace definitions {
-const search_values programming_languages = {
-    {"ALGOL"        , {"algol"                           }, policy_standard},
-    {"ActionScript" , {"actionscript"                    }, policy_standard},
-    {"Assembly"     , {"assembly", "assembler"           }, policy_standard},
-    {"B#"           , {"b#"                              }, policy_standard},
-    {"Bash"         , {"bash"                            }, policy_standard},
-    {"Batch"        , {"batch"                           }, policy_standard},
-    {"C++"          , {"c++", "cpp", "sepples", "seppels"}, policy_standard},
-    {"C#"           , {"c#"                              }, policy_standard},
-    {"Clojure"      , {"clojure"                         }, policy_standard, {"clojurescript"}},
-    {"ClojureScript", {"clojurescript"                   }, policy_standard},
-    {"COBOL"        , {"cobol"                           }, policy_standard},
-    {"CoffeeScript" , {"coffeescript"                    }, policy_standard},
-    {"CSS"          , {"css"                             }, policy_standard},
-    {"DCL"          , {"dcl"                             }, policy_standard},
-    {"Delphi"       , {"delphi"                          }, policy_standard},
-    {"Elixir"       , {"elixir"                          }, policy_standard},
-    {"Erlang"       , {"erlang"                          }, policy_standard},
-    {"F#"           , {"f#"                              }, policy_standard},
-    {"Forth"        , {"forth"                           }, policy_substring_risk},
-    {"Fortran"      , {"fortran"                         }, policy_standard},
-    {"GLSL"         , {"glsl"                            }, policy_standard},
-    {"Golang"       , {"golang"                          }, policy_standard},
-    {"Haskell"      , {"haskell"                         }, policy_standard},
-    {"HolyC"        , {"holyc"                           }, policy_standard},
-    {"HTML"         , {"html"                            }, policy_standard},
-    {"J#"           , {"j#"                              }, policy_standard},
-    {"J++"          , {"j++"                             }, policy_standard},
-    {"Java"         , {"java"                            }, policy_standard, {"javascript"}},
-    {"JavaScript"   , {"javascript", "js"                }, policy_substring_risk},
-    {"Kotlin"       , {"kotlin"                          }, policy_standard},
-    {"Lisp"         , {"lisp"                            }, policy_standard},
-    {"Machine code" , {"machine code"                    }, policy_standard},
-    {"MATLAB"       , {"matlab"                          }, policy_standard},
-    {"XML"          , {"xml"                             }, policy_standard},
-    {"Objective-C"  , {"objective-c", "object-c"         }, policy_standard},
-    {"OCaml"        , {"ocaml"                           }, policy_standard},
-    {"Opal"         , {"opal"                            }, policy_standard},
-    {"Pascal"       , {"pascal"                          }, policy_standard},
-    {"PHP"          , {"php"                             }, policy_standard},
-    {"PostScript"   , {"postscript"                      }, policy_standard},
-    {"PowerShell"   , {"powershell"                      }, policy_standard},
-    {"Pro*C"        , {"pro*c"                           }, policy_standard},
-    {"Python"       , {"python"                          }, policy_standard},
-    {"R++"          , {"r++"                             }, policy_standard},
-    {"Racket"       , {"racket"                          }, policy_standard},
-    {"Ruby"         , {"ruby"                            }, policy_standard},
-    {"Rust"         , {"rust"                            }, policy_standard},
-    {"Scala"        , {"scala"                           }, policy_standard},
-    {"Scheme"       , {"Scheme"                          }, policy_case_sensitive},
-    {"Smalltalk"    , {"smalltalk"                       }, policy_standard},
-    {"SQL"          , {"sql"                             }, policy_standard},
-    {"Swift"        , {"swift"                           }, policy_standard},
-    {"TypeScript"   , {"typescript"                      }, policy_standard},
-    {"VHDL"         , {"vhdl"                            }, policy_standard},
-    {"Zig"          , {"zig"                             }, policy_substring_risk},
-    {"Lua"          , {"lua"                             }, policy_substring_risk},
-    {"Ada"          , {"ada"                             }, policy_substring_risk},
-    {"Nim"          , {"nim"                             }, policy_substring_risk},
-    {"Perl"         , {"perl"                            }, policy_substring_risk},
-    {"Unity"        , {"unity"                           }, policy_substring_risk},
-    {"C"            , {"c", "C"                          }, policy_single_letter},
-    {"B"            , {"B"                               }, policy_single_letter},
-    {"D"            , {"D"                               }, policy_single_letter},
-    {"J"            , {"J"                               }, policy_single_letter},
-    {"R"            , {"R"                               }, policy_single_letter},
-    {"BASIC"        , {"BASIC"                           }, policy_case_sensitive},
-    {"Go"           , {"Go"                              }, policy_case_sensitive}
-};
-const search_values memes = {
-    {"\"In Haskell, this is just ...\""                 , {"in haskell this is just"                  }, policy_sentence},
-    {"\"In Lisp, this is just ...\""                    , {"in lisp this is just"                     }, policy_sentence},
-    {"\"... is the most powerful programming language\"", {"is the most powerful programming language"}, policy_sentence},
-    {"\"First for ...\""                                , {"first for"                                }, policy_sentence},
-    {"\"nth for ...\""                                  , {"nth for"                                  }, policy_sentence},
-    {"The word \"algorithm\" and nothing else"          , {"algorithm"                                }, policy_single_word}
-};
-const search_values topics = {
-    {"SICP"                  , {"sicp"              }, policy_substring_risk},
-    {"OOP/POO"               , {"oop", "poo"        }, policy_substring_risk},
-    {"Functional programming", {"functional", "fp"  }, policy_substring_risk},
-    {"Autism"                , {"autism", "autistic"}, policy_standard},
-    {"Design patterns"       , {"design pattern"    }, policy_standard},
-    {"Anime"                 , {"anime", "weeb"     }, policy_standard},
-    {"CMake"                 , {"cmake"             }, policy_standard},
-    {"Makefiles"             , {"makefile"          }, policy_standard},
-    {"Monads"                , {"monad"             }, policy_standard},
-    {"SOLID"                 , {"SOLID"             }, policy_case_sensitive},
-    {"OpenGL"                , {"opengl"            }, policy_standard},
-    {"Metaprogramming"       , {"metaprogramming"   }, policy_standard},
-    {"Vulkan"                , {"vulkan"            }, policy_standard}
-};
-const search_values programming_jokes = {
-    {"Fizz"       , {"fizz"       }, (policy_standard &~ policy_unique) | policy_count_all ,      {"fizzbuzz"}},
-    {"Buzz"       , {"buzz"       }, (policy_standard &~ policy_unique) | policy_count_all ,      {"fizzbuzz"}},
-    {"FizzBuzz"   , {"fizzbuzz"   }, (policy_standard &~ policy_unique) | policy_count_all},
-    {"Foo"        , {"foo"        }, (policy_substring_risk &~ policy_unique) | policy_count_all, {"foobar"}},
-    {"Bar"        , {"bar"        }, (policy_substring_risk &~ policy_unique) | policy_count_all, {"foobar"}},
-    {"FooBar"     , {"foobar"     }, (policy_standard &~ policy_unique) | policy_count_all},
-    {"Hello World", {"hello world"}, (policy_sentence &~ policy_unique) | policy_count_all}
-};
-const search_values insults = {
-    {"Cniles"        , {"cnile", "c-nile"              }, policy_standard},
-    {"Transsexuals"  , {"tranny", "trannie"            }, policy_standard},
-    {"Gays"          , {"fag", "faggot", "gay"         }, policy_standard},
-    {"Codemonkeys"   , {"codemonkey", "code-monkey"    }, policy_standard},
-    {"Brainlets"     , {"brainlet", "retard"           }, policy_standard},
-    {"Virgins"       , {"virgin"                       }, policy_standard},
-    {"Indians"       , {"pajeet", "curry", "poo in loo"}, policy_standard},
-    {"Indians"       , {"poos"                         }, policy_substring_risk},
-    {"Blacks"        , {"nigger"                       }, policy_standard},
-    {"Asians"        , {"chink"                        }, policy_standard},
-    {"Web developers", {"webshit"                      }, policy_standard}
-};
-
-const search_values buzzwords = {
-    {"Based"  , {"based" }, policy_standard},
-    {"Seethe" , {"seeth" }, policy_standard},
-    {"Cringe" , {"cringe"}, policy_standard}
-};
-} // namespace definitions
+constexpr std::array count_helper_begin_separators = {" ", "("};
+constexpr std::array count_helper_end_separators = {" ", "-", ",", ".", "?", "!", ")", "\"", "\"", "s", "fag"};
 
 char remove_punctuation_helper(char c) {
     switch(c) {
@@ -178,91 +37,239 @@ char remove_punctuation_helper(char c) {
         }
     }
 }
-std::size_t count_helper(std::string_view&& post, const std::string& language) {
-    constexpr std::array begin_separators = {" ", "("};
-    constexpr std::array end_separators = {" ", "-", ",", ".", "?", "!", ")", "\"", "\"", "s", "fag"};
-    std::size_t n = 0;
-    for (auto begin_separator : begin_separators) {
-        for (auto end_separator : end_separators) {
-            n += toolbox::string::count(post, begin_separator + language + end_separator);
-        }
-    }
-    if (toolbox::string::ends_with(post, " " + language) || toolbox::string::starts_with(post, language + " ")) {
-        ++n;
-    }
-    return n;
-}
-std::size_t search_helper(dpt::statistics::mentions_counter& mentions, std::string post, const search_value& search_val) {
-    if (!(search_val.policies & policy_no_transform)) {
-        if (search_val.policies & policy_lowercase) {
+std::string transform_helper(std::string post, int policies) {
+    if (!(policies & dpt::policy_no_transform)) {
+        if (policies & dpt::policy_lowercase) {
             std::transform(post.begin(), post.end(), post.begin(), [](char c){ return std::tolower(c); });
         }
-        if (search_val.policies & policy_no_punctuation) {
+        if (policies & dpt::policy_no_punctuation) {
             std::transform(post.begin(), post.end(), post.begin(), remove_punctuation_helper);
             post.erase(std::unique(post.begin(), post.end(), [](char lhs, char rhs){ return (lhs == rhs) && (lhs == ' '); }), post.end());
         }
     }
+    return post;
+}
 
-    std::size_t occurences = 0;
+std::shared_ptr<const dpt::matcher>& active_matcher() {
+    static std::shared_ptr<const dpt::matcher> m = std::make_shared<const dpt::matcher>(dpt::definitions::builtin());
+    return m;
+}
+std::filesystem::file_time_type last_write_time_helper(const std::string& path) {
+    std::error_code ec;
+    auto t = std::filesystem::last_write_time(path, ec);
+    return ec ? std::filesystem::file_time_type::min() : t;
+}
+} // namespace
+
+namespace dpt {
+matcher::matcher(const dpt::definitions& defs)
+: definitions_version{defs.version()}, pattern_sets{}, used_transforms{}, values{}, code_snippet_pattern{} {
+    compile(defs.programming_languages, &dpt::statistics::language_mentions);
+    for (const auto& search_val : defs.programming_languages) {
+        for (const auto& token : search_val.tokens) {
+            search_value single_word_val {"The word \"" + token + "\" and nothing else", {token}, policy_single_word};
+            compile(single_word_val, &dpt::statistics::meme_posts, true);
+        }
+    }
+    compile(defs.memes, &dpt::statistics::meme_posts);
+    compile(defs.topics, &dpt::statistics::topic_discussions);
+    compile(defs.insults, &dpt::statistics::insults);
+    compile(defs.programming_jokes, &dpt::statistics::programming_jokes);
+    compile(defs.buzzwords, &dpt::statistics::buzzwords);
+    code_snippet_pattern = pattern_sets[transform_none].add("class=\"prettyprint\"");
+    used_transforms[transform_none] = true;
+
+    for (auto& patterns : pattern_sets) {
+        patterns.compile();
+    }
+}
+
+void matcher::compile(const dpt::search_values& search_vals, dpt::statistics::mentions_counter dpt::statistics::* counter) {
+    for (const auto& search_val : search_vals) {
+        compile(search_val, counter, false);
+    }
+}
+
+void matcher::compile(const dpt::search_value& search_val, dpt::statistics::mentions_counter dpt::statistics::* counter, bool unquoted_only) {
+    int transform_policies = (search_val.policies & policy_no_transform) ? 0 : search_val.policies;
+    transform_t transform = static_cast<transform_t>(((transform_policies & policy_lowercase) ? transform_lowercase : transform_none)
+                                                   | ((transform_policies & policy_no_punctuation) ? transform_no_punctuation : transform_none));
+    auto& patterns = pattern_sets[transform];
+    used_transforms[transform] = true;
+
+    compiled_value& val = values.emplace_back();
+    val.key = search_val.key;
+    val.counter = counter;
+    val.policies = search_val.policies;
+    val.transform = transform;
+    val.unquoted_only = unquoted_only;
     for (const auto& token : search_val.tokens) {
         if (search_val.policies & policy_simple_count) {
-            occurences += toolbox::string::count(post, token);
+            val.patterns.push_back(patterns.add(token));
         } else if (search_val.policies & policy_count_helper) {
-            occurences += count_helper(post, token);
-        } else if (search_val.policies & policy_exact_match) {
-            if (toolbox::string::trim(post) == token) {
-                occurences += 1;
+            for (std::string_view begin_separator : count_helper_begin_separators) {
+                for (std::string_view end_separator : count_helper_end_separators) {
+                    val.patterns.push_back(patterns.add(std::string(begin_separator) + token + std::string(end_separator)));
+                }
             }
-        } else {
-            //
+            val.tokens.push_back(token);
+        } else if (search_val.policies & policy_exact_match) {
+            val.tokens.push_back(token);
         }
     }
-
     for (const auto& token : search_val.occurs_in) {
-        occurences -= toolbox::string::count(post, token);
+        val.occurs_in.push_back(patterns.add(token));
     }
+}
 
-    if (occurences != 0) {
-        if (search_val.policies & policy_unique) {
-            mentions[search_val.key] += 1;
-        } else if (search_val.policies & policy_count_all) {
-            mentions[search_val.key] += occurences;
-        } else {
-            //
+matcher::match_result matcher::match(const dpt::statistics::post& post) const {
+    match_result result {{}, 0};
+    std::array<std::string, transform_count> texts{};
+    std::array<std::vector<std::size_t>, transform_count> counts{};
+    static constexpr std::array<int, transform_count> transform_policies = {
+        policy_no_transform, policy_lowercase, policy_no_punctuation, policy_lowercase | policy_no_punctuation
+    };
+    for (std::size_t t = 0; t < transform_count; ++t) {
+        if (used_transforms[t]) {
+            texts[t] = transform_helper(post.text, transform_policies[t]);
+            pattern_sets[t].count(texts[t], counts[t]);
         }
     }
-    return occurences;
-}
-} // namespace
 
-namespace dpt {
-void analyse(dpt::statistics& stats) {
-    for (const auto& post : stats.posts) {
-        for (const auto& search_val : definitions::programming_languages) {
-            search_helper(stats.language_mentions, post.text, search_val);
-            if (!post.quotes || post.quotes_op) {
-                for (const auto& token : search_val.tokens) {
-                    search_value single_word_val {"The word \"" + token + "\" and nothing else", {token}, policy_single_word};
-                    search_helper(stats.meme_posts, post.text, single_word_val);
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        const auto& val = values[i];
+        if (val.unquoted_only && post.quotes && !post.quotes_op) {
+            continue;
+        }
+        const auto& text = texts[val.transform];
+        const auto& count = counts[val.transform];
+
+        std::size_t occurences = 0;
+        for (auto id : val.patterns) {
+            occurences += count[id];
+        }
+        if (val.policies & policy_simple_count) {
+            //
+        } else if (val.policies & policy_count_helper) {
+            for (const auto& token : val.tokens) {
+                if (toolbox::string::ends_with(text, " " + token) || toolbox::string::starts_with(text, token + " ")) {
+                    ++occurences;
+                }
+            }
+        } else if (val.policies & policy_exact_match) {
+            const std::string trimmed = toolbox::string::trim(text);
+            for (const auto& token : val.tokens) {
+                if (trimmed == token) {
+                    occurences += 1;
                 }
             }
         }
-        for (const auto& search_val : definitions::memes) {
-            search_helper(stats.meme_posts, post.text, search_val);
+        for (auto id : val.occurs_in) {
+            occurences -= count[id];
         }
-        for (const auto& search_val : definitions::topics) {
-            search_helper(stats.topic_discussions, post.text, search_val);
+
+        if (occurences != 0) {
+            if (val.policies & policy_unique) {
+                result.increments.emplace_back(static_cast<std::uint32_t>(i), 1);
+            } else if (val.policies & policy_count_all) {
+                result.increments.emplace_back(static_cast<std::uint32_t>(i), occurences);
+            } else {
+                //
+            }
         }
-        for (const auto& search_val : definitions::insults) {
-            search_helper(stats.insults, post.text, search_val);
+    }
+    result.n_code_snippets = counts[transform_none][code_snippet_pattern];
+    return result;
+}
+
+void matcher::apply(dpt::statistics& stats, const match_result& result) const {
+    for (const auto& [value_index, amount] : result.increments) {
+        if (value_index < values.size()) {
+            const auto& val = values[value_index];
+            (stats.*val.counter)[val.key] += amount;
         }
-        for (const auto& search_val : definitions::programming_jokes) {
-            search_helper(stats.programming_jokes, post.text, search_val);
+    }
+    stats.n_code_snippets += result.n_code_snippets;
+}
+
+void matcher::analyse(dpt::statistics& stats, const dpt::statistics::post& post) const {
+    apply(stats, match(post));
+}
+
+std::uint64_t matcher::version() const {
+    return definitions_version;
+}
+
+void analyse(dpt::statistics& stats, const dpt::matcher& m, dpt::post_memo* memo) {
+    if (stats.analyses_on_ingest()) {
+        return;
+    }
+    for (const auto& post : stats.posts) {
+        auto result = m.match(post);
+        m.apply(stats, result);
+        if (memo && post.no) {
+            memo->store(stats.board, stats.id, post.no, m.version(), std::move(result));
+        }
+    }
+}
+
+dpt::statistics::ingest_function ingest_analyser(std::shared_ptr<const dpt::matcher> m, dpt::post_memo* memo) {
+    return [m = std::move(m), memo](dpt::statistics& stats, const dpt::statistics::post& post) {
+        auto result = m->match(post);
+        m->apply(stats, result);
+        if (memo && post.no) {
+            memo->store(stats.board, stats.id, post.no, m->version(), std::move(result));
+        }
+    };
+}
+
+std::shared_ptr<const dpt::matcher> current_matcher() {
+    return std::atomic_load(&active_matcher());
+}
+
+void install_matcher(std::shared_ptr<const dpt::matcher> m) {
+    std::atomic_store(&active_matcher(), std::move(m));
+}
+
+definitions_watcher::definitions_watcher(std::string path, std::chrono::milliseconds interval)
+: path{std::move(path)}, interval{interval}, last_write_time{last_write_time_helper(this->path)},
+  mutex{}, stop_signal{}, stopping{false}, thread{} {
+    thread = std::thread{[this]() {
+        std::unique_lock lock {mutex};
+        while (!stop_signal.wait_for(lock, this->interval, [this](){ return stopping; })) {
+            lock.unlock();
+            reload_if_changed();
+            lock.lock();
         }
-        for (const auto& search_val : definitions::buzzwords) {
-            search_helper(stats.buzzwords, post.text, search_val);
+    }};
+}
+
+definitions_watcher::~definitions_watcher() {
+    {
+        std::lock_guard lock {mutex};
+        stopping = true;
+    }
+    stop_signal.notify_all();
+    thread.join();
+}
+
+bool definitions_watcher::reload_if_changed() {
+    auto write_time = last_write_time_helper(path);
+    if (write_time == last_write_time) {
+        return false;
+    }
+    last_write_time = write_time;
+    try {
+        auto m = std::make_shared<const dpt::matcher>(dpt::definitions::from_file(path));
+        if (m->version() == current_matcher()->version()) {
+            return false;
         }
-        stats.n_code_snippets += toolbox::string::count(post.text, "class=\"prettyprint\"");
+        install_matcher(std::move(m));
+        std::cerr << "Reloaded definitions from " << path << std::endl;
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "Keeping previous definitions: " << e.what() << std::endl;
+        return false;
     }
 }
 } // namespace dpt
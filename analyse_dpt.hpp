@@ -1,7 +1,92 @@
 #pragma once
 
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include "dpt_definitions.hpp"
 #include "dpt_thread_statistics.hpp"
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include "search_toolbox.hpp"
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 
 namespace dpt {
-void analyse(dpt::statistics& thrd);
+/// definitions compiled into one pattern automaton per text transformation, so every post is transformed
+/// at most once per transformation and scanned once per automaton instead of once per token
+class matcher {
+public:
+    /// what a single post contributes to the statistics, can be stored and applied again later
+    struct match_result {
+        std::vector<std::pair<std::uint32_t, std::uint64_t>> increments; // compiled value index, amount
+        std::uint64_t n_code_snippets;
+    };
+
+    explicit matcher(const dpt::definitions& defs);
+
+    match_result match(const dpt::statistics::post& post) const;
+    void apply(dpt::statistics& stats, const match_result& result) const;
+    void analyse(dpt::statistics& stats, const dpt::statistics::post& post) const;
+    std::uint64_t version() const;
+private:
+    enum transform_t {transform_none, transform_lowercase, transform_no_punctuation, transform_lowercase_no_punctuation, transform_count};
+    using pattern_id = toolbox::search::pattern_set::pattern_id;
+    struct compiled_value {
+        std::string key;
+        dpt::statistics::mentions_counter dpt::statistics::* counter;
+        int policies;
+        transform_t transform;
+        bool unquoted_only;
+        std::vector<pattern_id> patterns;
+        std::vector<pattern_id> occurs_in;
+        std::vector<std::string> tokens; // exact_match and count_helper start/end checks
+    };
+
+    void compile(const dpt::search_values& values, dpt::statistics::mentions_counter dpt::statistics::* counter);
+    void compile(const dpt::search_value& val, dpt::statistics::mentions_counter dpt::statistics::* counter, bool unquoted_only);
+
+    std::uint64_t definitions_version;
+    std::array<toolbox::search::pattern_set, transform_count> pattern_sets;
+    std::array<bool, transform_count> used_transforms; // exact matches use a transformation without adding patterns
+    std::vector<compiled_value> values;
+    pattern_id code_snippet_pattern;
+};
+
+class post_memo;
+
+/// stores the match result of every post with a post number in the memo, if one is given.
+/// statistics that analyse on ingest have already been analysed and are left alone
+void analyse(dpt::statistics& stats, const dpt::matcher& m, dpt::post_memo* memo = nullptr);
+/// for statistics::analyse_on_ingest, analyses every post as it is added, exactly like analyse would
+dpt::statistics::ingest_function ingest_analyser(std::shared_ptr<const dpt::matcher> m, dpt::post_memo* memo = nullptr);
+
+/// the installed matcher is swapped atomically, analyses already running keep the matcher they started with
+std::shared_ptr<const dpt::matcher> current_matcher();
+void install_matcher(std::shared_ptr<const dpt::matcher> m);
+
+/// polls a definitions file and installs a freshly compiled matcher whenever it changes,
+/// a file that fails to load is reported and the previous matcher stays active
+class definitions_watcher {
+public:
+    definitions_watcher(std::string path, std::chrono::milliseconds interval);
+    ~definitions_watcher();
+private:
+    definitions_watcher(const definitions_watcher&) = delete;
+    definitions_watcher& operator=(const definitions_watcher&) = delete;
+
+    /// only called from the watcher thread, which is the only one touching last_write_time after construction
+    bool reload_if_changed();
+
+    const std::string path;
+    const std::chrono::milliseconds interval;
+    std::filesystem::file_time_type last_write_time;
+    std::mutex mutex;
+    std::condition_variable stop_signal;
+    bool stopping;
+    std::thread thread;
+};
 } // namespace dpt
@@ -0,0 +1,202 @@
+#include <algorithm>
+#include "analyse_dpt.hpp"
+#include "batch_dpt.hpp"
+#include "binary_toolbox.hpp"
+#include "collect_dpt.hpp"
+#include <cstdint>
+#include "dpt_inverted_index.hpp"
+#include "dpt_thread_statistics.hpp"
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include "hash_toolbox.hpp"
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include "thread_toolbox.hpp"
+#include <utility>
+#include <vector>
+
+namespace {
+constexpr std::uint64_t partial_magic = 0x3150415254504400ull; // "\0DPTRAP1"
+constexpr std::uint32_t partial_format_version = 2;
+
+void write_statistics(std::ostream& os, const dpt::statistics& stats) {
+    using toolbox::binary::write;
+
+    write(os, static_cast<std::uint32_t>(stats.id));
+    write(os, stats.board);
+    write(os, stats.title);
+    write(os, stats.timestamp);
+    write(os, static_cast<std::uint64_t>(stats.n_code_snippets));
+    write(os, static_cast<std::uint64_t>(stats.n_ingested_posts));
+    for (auto counter : dpt::statistics_counters) {
+        write(os, static_cast<std::uint32_t>((stats.*counter).size()));
+        for (const auto& [key, mentions] : stats.*counter) {
+            write(os, key);
+            write(os, static_cast<std::uint64_t>(mentions));
+        }
+    }
+}
+bool read_statistics(std::istream& is, dpt::partial_result& partial) {
+    using toolbox::binary::read;
+
+    std::uint32_t id{0};
+    std::string board, title, timestamp;
+    std::uint64_t n_code_snippets{0};
+    std::uint64_t n_ingested_posts{0};
+    if (!read(is, id) || !read(is, board) || !read(is, title) || !read(is, timestamp) || !read(is, n_code_snippets) || !read(is, n_ingested_posts)) {
+        return false;
+    }
+    dpt::statistics stats {id, board, title, timestamp};
+    stats.n_code_snippets = n_code_snippets;
+    stats.n_ingested_posts = n_ingested_posts;
+    for (auto counter : dpt::statistics_counters) {
+        std::uint32_t n_keys{0};
+        if (!read(is, n_keys)) {
+            return false;
+        }
+        for (std::uint32_t i = 0; i < n_keys; ++i) {
+            std::string key;
+            std::uint64_t mentions{0};
+            if (!read(is, key) || !read(is, mentions)) {
+                return false;
+            }
+            (stats.*counter)[key] += mentions;
+        }
+    }
+    partial.add(stats);
+    return true;
+}
+} // namespace
+
+namespace dpt {
+partial_result::partial_result(std::uint64_t version) : version{version}, threads{} {}
+
+void partial_result::add(const dpt::statistics& stats) {
+    thread_key key {stats.board, stats.id};
+    auto it = threads.find(key);
+    if (it == threads.end()) {
+        it = threads.emplace(std::move(key), dpt::statistics{stats.id, stats.board, stats.title, stats.timestamp}).first;
+    }
+    it->second.merge(stats);
+}
+
+void partial_result::merge(const partial_result& other) {
+    if (version != other.version) {
+        throw std::runtime_error("partial results were analysed with different definitions");
+    }
+    for (const auto& [key, stats] : other.threads) {
+        add(stats);
+    }
+}
+
+dpt::statistics partial_result::total() const {
+    dpt::statistics stats {0, "*", "All threads", ""};
+    for (const auto& [key, thread_stats] : threads) {
+        stats.merge(thread_stats);
+    }
+    return stats;
+}
+
+bool partial_result::save(const std::string& path) const {
+    using toolbox::binary::write;
+
+    return toolbox::binary::write_file_atomically(path, [this](std::ostream& file) {
+        write(file, partial_magic);
+        write(file, partial_format_version);
+        write(file, version);
+        write(file, static_cast<std::uint64_t>(threads.size()));
+        for (const auto& [key, stats] : threads) {
+            write_statistics(file, stats);
+        }
+    });
+}
+
+partial_result partial_result::load(const std::string& path) {
+    using toolbox::binary::read;
+
+    std::ifstream file {path, std::ios::binary};
+    std::uint64_t magic{0};
+    std::uint32_t format_version{0};
+    std::uint64_t version{0};
+    std::uint64_t n_threads{0};
+    if (!read(file, magic) || !read(file, format_version) || !read(file, version) || !read(file, n_threads)
+        || (magic != partial_magic) || (format_version != partial_format_version)) {
+        throw std::runtime_error(path + " is not a dptstat partial result");
+    }
+    partial_result partial {version};
+    for (std::uint64_t i = 0; i < n_threads; ++i) {
+        if (!read_statistics(file, partial)) {
+            throw std::runtime_error(path + " is truncated");
+        }
+    }
+    return partial;
+}
+
+std::vector<std::string> shard_files(const std::vector<std::string>& paths, std::size_t shard, std::size_t n_shards) {
+    namespace fs = std::filesystem;
+
+    std::vector<std::string> files;
+    auto add_file = [&](const fs::path& file) {
+        if (file.extension() != ".json") {
+            return;
+        }
+        const std::string shard_key = file.parent_path().filename().string() + "/" + file.filename().string();
+        if ((toolbox::hash::fnv1a(shard_key) % n_shards) == shard) {
+            files.push_back(file.string());
+        }
+    };
+    for (const auto& path : paths) {
+        if (fs::is_directory(path)) {
+            for (const auto& entry : fs::recursive_directory_iterator(path)) {
+                if (entry.is_regular_file()) {
+                    add_file(entry.path());
+                }
+            }
+        } else {
+            add_file(path);
+        }
+    }
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+dpt::partial_result map_shard(const std::vector<std::string>& files, std::shared_ptr<const dpt::matcher> m, std::size_t n_workers, const std::optional<std::string>& index_dir) {
+    dpt::partial_result partial {m->version()};
+    std::mutex partial_mutex;
+    toolbox::thread::parallel_for(files.size(), n_workers, [&](std::size_t i) {
+        const std::filesystem::path file {files[i]};
+        try {
+            std::ifstream is {file, std::ios::binary};
+            std::stringstream ss;
+            ss << is.rdbuf();
+            auto stats = dpt::read_thread(file.parent_path().filename().string(), ss.str(), dpt::ingest_analyser(m), 0, index_dir.has_value());
+            if (index_dir && !stats.index->save(dpt::index_path(*index_dir, stats.board, stats.id))) {
+                std::cerr << "Could not save the index of " << files[i] << std::endl;
+            }
+            std::lock_guard lock {partial_mutex};
+            partial.add(stats);
+        } catch (const std::exception& e) {
+            std::cerr << "Skipping " << files[i] << ": " << e.what() << std::endl;
+        }
+    });
+    return partial;
+}
+
+dpt::partial_result reduce(const std::vector<std::string>& partial_paths) {
+    if (partial_paths.empty()) {
+        throw std::runtime_error("no partial results to reduce");
+    }
+    auto result = partial_result::load(partial_paths.front());
+    for (std::size_t i = 1; i < partial_paths.size(); ++i) {
+        result.merge(partial_result::load(partial_paths[i]));
+    }
+    return result;
+}
+} // namespace dpt
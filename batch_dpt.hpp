@@ -0,0 +1,42 @@
+#pragma once
+
+#include "analyse_dpt.hpp"
+#include <cstdint>
+#include "dpt_thread_statistics.hpp"
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace dpt {
+/// the counters of a set of threads, merging partial results is associative and commutative,
+/// so any number of partials can be reduced in any order and grouping to the same result
+struct partial_result {
+    using thread_key = std::pair<std::string, unsigned int>; // board, thread no
+
+    explicit partial_result(std::uint64_t version);
+
+    std::uint64_t version;
+    std::map<thread_key, dpt::statistics> threads;
+
+    /// counters of a thread that is already present are added up
+    void add(const dpt::statistics& stats);
+    /// throws std::runtime_error if the partials were analysed with different definitions
+    void merge(const partial_result& other);
+    dpt::statistics total() const;
+
+    bool save(const std::string& path) const;
+    /// throws std::runtime_error if the file can't be read
+    static partial_result load(const std::string& path);
+};
+
+/// every thread json file (<board>/<thread no>.json) below paths belongs to shard fnv1a(<board>/<file name>) % n_shards
+std::vector<std::string> shard_files(const std::vector<std::string>& paths, std::size_t shard, std::size_t n_shards);
+/// analyses the thread json files of a shard, posts are analysed while a thread is parsed so no post text is kept.
+/// if index_dir is given the inverted index of every thread is saved to index_path(index_dir, board, thread no)
+dpt::partial_result map_shard(const std::vector<std::string>& files, std::shared_ptr<const dpt::matcher> m, std::size_t n_workers, const std::optional<std::string>& index_dir = std::nullopt);
+/// throws std::runtime_error if a partial can't be read or the partials don't match
+dpt::partial_result reduce(const std::vector<std::string>& partial_paths);
+} // namespace dpt
@@ -0,0 +1,31 @@
+#include "async_http_toolbox.hpp"
+#include "benchmark_dpt.hpp"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+namespace dpt {
+bool benchmark_http(std::ostream& os, const std::string& host, std::uint16_t port, std::size_t n_requests, std::size_t n_connections) {
+    toolbox::async_http::event_loop loop;
+    toolbox::async_http::session session {loop, host, port, n_connections};
+    std::size_t n_ok = 0;
+    std::size_t n_bytes = 0;
+    const auto begin = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < n_requests; ++i) {
+        session.get(std::to_string(i) + ".json", [&](toolbox::async_http::response&& res) {
+            if (res.ok()) {
+                ++n_ok;
+                n_bytes += res.body.size();
+            }
+        });
+    }
+    loop.run();
+    const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - begin);
+
+    os << n_ok << "/" << n_requests << " requests succeeded over " << n_connections << " connection(s), "
+       << n_bytes << " bytes in " << elapsed.count() << " ms" << std::endl;
+    return n_ok == n_requests;
+}
+} // namespace dpt
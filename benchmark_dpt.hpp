@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+namespace dpt {
+/// requests /0.json to /<n_requests - 1>.json from host over at most n_connections connections on one event loop,
+/// the way collect downloads threads, and reports how many succeeded and how long it took.
+/// tools/latency_server.py answers these requests with 4chan-like latency. returns false if a request failed
+bool benchmark_http(std::ostream& os, const std::string& host, std::uint16_t port, std::size_t n_requests, std::size_t n_connections);
+} // namespace dpt
@@ -1,52 +1,204 @@
+#include <algorithm>
+#include "analyse_dpt.hpp"
+#include "async_http_toolbox.hpp"
 #include "collect_dpt.hpp"
+#include <cstdint>
+#include "dpt_inverted_index.hpp"
+#include "dpt_post_memo.hpp"
+#include "dpt_snapshot.hpp"
 #include "dpt_thread_statistics.hpp"
-#include "http_toolbox.hpp"
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <regex>
 #include <sstream>
+#include <string>
 #include <string_view>
 #include "string_toolbox.hpp"
+#include "thread_toolbox.hpp"
 #include <vector>
 
 #define BOOST_JSON_STANDALONE
 #include "boost/json/src.hpp"
 
+namespace {
+struct thread_job {
+    std::size_t general_index;
+    std::size_t thread_index;
+    std::int64_t last_modified; // only recorded once the thread was ingested, so a failed download is never resumed
+};
+/// a thread matching another general as well is downloaded once and copied there afterwards
+struct thread_copy {
+    std::size_t general_index;
+    std::size_t job_index;
+};
+
+void ingest_posts_helper(dpt::statistics& stats, const boost::json::array& arr, const dpt::matcher* m, dpt::post_memo* memo) {
+    for (const auto& post : arr) {
+        const boost::json::object& obj = post.get_object();
+        const std::uint64_t post_no = obj.at("no").as_int64();
+        if (memo && !stats.index) {
+            if (const auto* result = memo->find(stats.board, stats.id, post_no, m->version())) {
+                m->apply(stats, *result);
+                ++stats.n_ingested_posts; // only posts with a comment were analysed and stored
+                continue;
+            }
+        }
+        if (obj.contains("com")) {
+            const std::string txt {obj.at("com").as_string()};
+            stats.add_post(txt, post_no);
+        }
+    }
+}
+
+void fetch_helper(toolbox::async_http::session& session, const std::string& object, std::string& destination) {
+    session.get(object, [&destination, object](toolbox::async_http::response&& res) {
+        if (res.ok()) {
+            destination = std::move(res.body);
+        } else {
+            std::cerr << "Could not fetch " << object << ": " << (res.status ? "HTTP " + std::to_string(res.status) : res.error) << std::endl;
+        }
+    });
+}
+} // namespace
+
 namespace dpt {
-std::vector<dpt::statistics> collect() {
-    using namespace toolbox::http;
-
-    session fourchannel_session {"a.4cdn.org"};
-    request catalog_request = fourchannel_session.get("g/catalog.json");
-    std::vector<dpt::statistics> threads;
-
-    if (catalog_request.send()) {
-        static std::vector<char> buffer;
-        std::size_t n_read = catalog_request.read_to_dynamic_buffer(buffer);
-        std::string_view catalog {buffer.data(), n_read};
-        boost::json::value val = boost::json::parse(catalog);
-        boost::json::array arr = val.get_array();
-        for (const auto& page : arr) {
-            for (const auto& thrd : page.at("threads").get_array()) {
-                boost::json::object obj = thrd.get_object();
-                if ((obj.if_contains("sub")) && (toolbox::string::starts_with(obj.at("sub").as_string(), "/dpt/"))) {
-                    auto& dpt_thread = threads.emplace_back(obj.at("no").as_int64(), obj.at("sub").as_string(), obj.at("now").as_string());
-                    request thread_request = fourchannel_session.get("g/thread/" + std::to_string(obj.at("no").as_int64()) + ".json");
-                    if (thread_request.send()) {
-                        static std::vector<char> thread_buffer;
-                        std::size_t n_read = thread_request.read_to_dynamic_buffer(thread_buffer);
-                        std::string_view thread_data {thread_buffer.data(), n_read};
-                        boost::json::value val = boost::json::parse(thread_data);
-                        boost::json::array arr = val.get_object().at("posts").get_array();
-                        for (const auto& post : arr) {
-                            boost::json::object obj = post.get_object();
-                            if (obj.contains("com")) {
-                                const std::string txt {obj.at("com").as_string()};
-                                dpt_thread.add_post(txt);
+target::target(std::string_view name, std::string_view board, std::string_view subject_prefix)
+: name{name}, board{board}, subject_prefix{subject_prefix}, subject_regex{} {}
+
+target::target(std::string_view name, std::string_view board, const std::regex& subject_regex)
+: name{name}, board{board}, subject_prefix{}, subject_regex{subject_regex} {}
+
+bool target::matches(std::string_view subject) const {
+    if (subject_regex) {
+        return std::regex_search(subject.begin(), subject.end(), *subject_regex);
+    }
+    return toolbox::string::starts_with(subject, subject_prefix);
+}
+
+std::vector<dpt::general> collect(const std::vector<dpt::target>& targets, std::shared_ptr<const dpt::matcher> m, dpt::post_memo* memo, const dpt::collect_options& opts) {
+    toolbox::async_http::event_loop loop;
+    toolbox::async_http::session fourchannel_session {loop, "a.4cdn.org", 80, opts.n_connections};
+    const dpt::snapshot* resume = (opts.resume && opts.resume->is_open() && (opts.resume->version() == m->version()) && !opts.build_index) ? opts.resume : nullptr;
+    std::vector<dpt::general> generals;
+    for (const auto& t : targets) {
+        generals.push_back({t, {}});
+    }
+
+    std::vector<std::string> boards;
+    for (const auto& t : targets) {
+        if (std::find(boards.begin(), boards.end(), t.board) == boards.end()) {
+            boards.push_back(t.board);
+        }
+    }
+    std::vector<std::string> catalogs(boards.size());
+    for (std::size_t i = 0; i < boards.size(); ++i) {
+        fetch_helper(fourchannel_session, boards[i] + "/catalog.json", catalogs[i]);
+    }
+    loop.run();
+
+    std::vector<thread_job> jobs;
+    std::vector<thread_copy> copies;
+    for (std::size_t i = 0; i < boards.size(); ++i) {
+        if (catalogs[i].empty()) {
+            continue;
+        }
+        try {
+            boost::json::value val = boost::json::parse(catalogs[i]);
+            boost::json::array arr = val.get_array();
+            for (const auto& page : arr) {
+                for (const auto& thrd : page.at("threads").get_array()) {
+                    boost::json::object obj = thrd.get_object();
+                    if (!obj.if_contains("sub")) {
+                        continue;
+                    }
+                    const std::size_t n_jobs = jobs.size();
+                    for (std::size_t g = 0; g < generals.size(); ++g) {
+                        if ((generals[g].target.board == boards[i]) && (generals[g].target.matches(obj.at("sub").as_string()))) {
+                            if (jobs.size() != n_jobs) {
+                                copies.push_back({g, n_jobs});
+                                continue;
+                            }
+                            const auto* last_modified = obj.if_contains("last_modified");
+                            if (resume && last_modified) {
+                                if (auto stats = resume->find(boards[i], obj.at("no").as_int64(), last_modified->as_int64())) {
+                                    if (memo) {
+                                        memo->touch(stats->board, stats->id, m->version());
+                                    }
+                                    generals[g].threads.push_back(std::move(*stats));
+                                    if (opts.on_thread) {
+                                        opts.on_thread(generals[g].target, generals[g].threads.back());
+                                    }
+                                    continue;
+                                }
+                            }
+                            auto& dpt_thread = generals[g].threads.emplace_back(obj.at("no").as_int64(), boards[i], obj.at("sub").as_string(), obj.at("now").as_string());
+                            if (opts.analyse_on_ingest) {
+                                dpt_thread.analyse_on_ingest(ingest_analyser(m, memo), opts.sample_size);
                             }
+                            if (opts.build_index) {
+                                dpt_thread.index = std::make_shared<dpt::inverted_index>(dpt_thread.id);
+                            }
+                            jobs.push_back({g, generals[g].threads.size() - 1, last_modified ? last_modified->as_int64() : 0});
                         }
                     }
                 }
             }
+        } catch (const std::exception& e) {
+            std::cerr << "Could not parse /" << boards[i] << "/ catalog: " << e.what() << std::endl;
+        }
+    }
+
+    std::vector<std::string> thread_data(jobs.size());
+    for (std::size_t i = 0; i < jobs.size(); ++i) {
+        const auto& dpt_thread = generals[jobs[i].general_index].threads[jobs[i].thread_index];
+        fetch_helper(fourchannel_session, dpt_thread.board + "/thread/" + std::to_string(dpt_thread.id) + ".json", thread_data[i]);
+    }
+    loop.run();
+
+    toolbox::thread::parallel_for(jobs.size(), opts.n_workers, [&](std::size_t i) {
+        auto& dpt_thread = generals[jobs[i].general_index].threads[jobs[i].thread_index];
+        std::string json = std::move(thread_data[i]);
+        if (!json.empty()) {
+            try {
+                ingest_thread(dpt_thread, json, m.get(), memo);
+                dpt_thread.last_modified = jobs[i].last_modified;
+                if (opts.on_thread) {
+                    opts.on_thread(generals[jobs[i].general_index].target, dpt_thread);
+                }
+            } catch (const std::exception& e) {
+                std::cerr << "Could not parse " << dpt_thread.thread_info_to_string() << ": " << e.what() << std::endl;
+            }
         }
+    });
+    for (const auto& c : copies) {
+        const auto& job = jobs[c.job_index];
+        generals[c.general_index].threads.push_back(generals[job.general_index].threads[job.thread_index]);
+        if (opts.on_thread) {
+            opts.on_thread(generals[c.general_index].target, generals[c.general_index].threads.back());
+        }
+    }
+    return generals;
+}
+
+void ingest_thread(dpt::statistics& stats, std::string_view thread_json, const dpt::matcher* m, dpt::post_memo* memo) {
+    boost::json::value val = boost::json::parse(thread_json);
+    ingest_posts_helper(stats, val.get_object().at("posts").get_array(), m, memo);
+}
+
+dpt::statistics read_thread(std::string_view board, std::string_view thread_json, dpt::statistics::ingest_function on_ingest, std::size_t sample_size, bool build_index) {
+    boost::json::value val = boost::json::parse(thread_json);
+    const boost::json::array& arr = val.get_object().at("posts").get_array();
+    const boost::json::object& op = arr.at(0).get_object();
+    const auto* sub = op.if_contains("sub");
+    dpt::statistics stats {static_cast<unsigned int>(op.at("no").as_int64()), std::move(board), sub ? std::string_view{sub->as_string()} : std::string_view{}, op.at("now").as_string()};
+    if (on_ingest) {
+        stats.analyse_on_ingest(std::move(on_ingest), sample_size);
+    }
+    if (build_index) {
+        stats.index = std::make_shared<dpt::inverted_index>(stats.id);
     }
-    return std::move(threads);
+    ingest_posts_helper(stats, arr, nullptr, nullptr);
+    return stats;
 }
 } // namespace dpt
@@ -1,9 +1,57 @@
 #pragma once
 
+#include "analyse_dpt.hpp"
+#include "dpt_post_memo.hpp"
 #include "dpt_thread_statistics.hpp"
-#include "http_toolbox.hpp"
+#include <functional>
+#include <memory>
+#include <optional>
+#include <regex>
+#include <string>
+#include <string_view>
 #include <vector>
 
 namespace dpt {
-std::vector<dpt::statistics> collect();
+class snapshot;
+
+/// a general is every thread on a board whose subject starts with the prefix, or matches the regex if one is given
+struct target {
+    target(std::string_view name, std::string_view board, std::string_view subject_prefix);
+    target(std::string_view name, std::string_view board, const std::regex& subject_regex);
+
+    std::string name;
+    std::string board;
+    std::string subject_prefix;
+    std::optional<std::regex> subject_regex;
+
+    bool matches(std::string_view subject) const;
+};
+struct collect_options {
+    std::size_t n_workers{1};
+    std::size_t n_connections{1};
+    /// analyse every post while the thread is parsed instead of keeping the post texts, see statistics::analyse_on_ingest
+    bool analyse_on_ingest{false};
+    std::size_t sample_size{0};
+    /// give every thread an inverted index of its posts, posts in the memo are analysed again to be indexed
+    bool build_index{false};
+    /// threads that haven't changed since this snapshot was written are taken from it instead of being downloaded,
+    /// if it was written with the same definitions and no index is built
+    const dpt::snapshot* resume{nullptr};
+    /// called with every thread once it has been ingested or restored, from the thread that ingested it
+    std::function<void(const dpt::target&, const dpt::statistics&)> on_thread{};
+};
+struct general {
+    dpt::target target;
+    std::vector<dpt::statistics> threads;
+};
+
+/// catalogs are fetched once per board, all threads are then downloaded concurrently over up to n_connections
+/// keep-alive connections driven by a single event loop, and parsed on up to n_workers threads.
+/// posts that are already in the memo are applied to the statistics straight away, without being sanitized or analysed again
+std::vector<dpt::general> collect(const std::vector<dpt::target>& targets, std::shared_ptr<const dpt::matcher> m, dpt::post_memo* memo, const dpt::collect_options& opts);
+/// adds every post of a thread in 4chan API json format
+void ingest_thread(dpt::statistics& stats, std::string_view thread_json, const dpt::matcher* m = nullptr, dpt::post_memo* memo = nullptr);
+/// same as ingest_thread, but the thread number, subject and time are taken from the opening post.
+/// if on_ingest is given the statistics analyse on ingest, see statistics::analyse_on_ingest
+dpt::statistics read_thread(std::string_view board, std::string_view thread_json, dpt::statistics::ingest_function on_ingest = {}, std::size_t sample_size = 0, bool build_index = false);
 } // namespace dpt
@@ -0,0 +1,129 @@
+#include <algorithm>
+#include <chrono>
+#include "collect_dpt.hpp"
+#include "dashboard_dpt.hpp"
+#include "dpt_thread_statistics.hpp"
+#include <mutex>
+#include <ostream>
+#include "report_dpt.hpp"
+#include <sstream>
+#include <string>
+#include "terminal_toolbox.hpp"
+#include <utility>
+#include <vector>
+
+namespace dpt {
+dashboard::dashboard(std::ostream& os, std::chrono::milliseconds refresh_interval)
+: os{os}, refresh_interval{refresh_interval}, screen{}, generals{}, changed{false}, stopping{false}, mutex{}, stop_signal{}, thread{} {
+    toolbox::terminal::enable_escape_sequences();
+    thread = std::thread([this]() { run(); });
+}
+
+dashboard::~dashboard() {
+    {
+        std::lock_guard lock {mutex};
+        stopping = true;
+    }
+    stop_signal.notify_one();
+    thread.join();
+    const bool fits = draw();
+    screen.release(os);
+    if (!fits) {
+        for (const auto& line : render(false)) {
+            os << line << '\n';
+        }
+        os.flush();
+    }
+}
+
+dashboard::live_general& dashboard::find(const dpt::target& target) {
+    for (auto& gen : generals) {
+        if ((gen.name == target.name) && (gen.board == target.board)) {
+            return gen;
+        }
+    }
+    return generals.emplace_back(live_general{target.name, target.board, {}});
+}
+
+void dashboard::update(const dpt::target& target, const dpt::statistics& stats) {
+    dpt::statistics counters {stats.id, stats.board, stats.title, stats.timestamp};
+    counters.merge(stats);
+
+    std::lock_guard lock {mutex};
+    auto& threads = find(target).threads;
+    thread_key key {stats.board, stats.id};
+    threads.erase(key);
+    threads.emplace(std::move(key), std::move(counters));
+    changed = true;
+}
+
+void dashboard::update(const std::vector<dpt::general>& collected) {
+    std::lock_guard lock {mutex};
+    for (const auto& gen : collected) {
+        auto& threads = find(gen.target).threads;
+        threads.clear();
+        for (const auto& stats : gen.threads) {
+            dpt::statistics counters {stats.id, stats.board, stats.title, stats.timestamp};
+            counters.merge(stats);
+            threads.emplace(thread_key{stats.board, stats.id}, std::move(counters));
+        }
+    }
+    changed = true;
+}
+
+std::vector<std::string> dashboard::render(bool compact) {
+    std::stringstream ss;
+    {
+        std::lock_guard lock {mutex};
+        for (const auto& gen : generals) {
+            dpt::statistics total {0, gen.board, "All threads", ""};
+            for (const auto& [key, stats] : gen.threads) {
+                total.merge(stats);
+            }
+            ss << "General " << gen.name << " on /" << gen.board << "/ - " << gen.threads.size() << " thread(s), "
+               << total.n_ingested_posts << " post(s)";
+            if (compact) {
+                auto top = std::max_element(total.language_mentions.begin(), total.language_mentions.end(), [](const auto& lhs, const auto& rhs) {
+                    return lhs.second < rhs.second;
+                });
+                if (top != total.language_mentions.end()) {
+                    ss << ", mostly " << top->first << " (" << top->second << ")";
+                }
+                ss << '\n';
+                continue;
+            }
+            ss << '\n'
+               << std::string(50, '=') << '\n'
+               << '\n';
+            report(ss, total);
+        }
+        changed = false;
+    }
+
+    std::vector<std::string> lines;
+    for (std::string line; std::getline(ss, line);) {
+        lines.push_back(std::move(line));
+    }
+    return lines;
+}
+
+bool dashboard::draw() {
+    const std::size_t n_rows = toolbox::terminal::rows();
+    auto lines = render(false);
+    const bool fits = lines.size() < n_rows;
+    screen.draw(os, fits ? std::move(lines) : render(true), n_rows);
+    return fits;
+}
+
+void dashboard::run() {
+    std::unique_lock lock {mutex};
+    while (!stopping) {
+        stop_signal.wait_for(lock, refresh_interval, [this]() { return stopping; });
+        if (changed && !stopping) {
+            lock.unlock();
+            draw();
+            lock.lock();
+        }
+    }
+}
+} // namespace dpt
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <chrono>
+#include "collect_dpt.hpp"
+#include <condition_variable>
+#include "dpt_thread_statistics.hpp"
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include "terminal_toolbox.hpp"
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace dpt {
+/// a live report of every general, summed over its threads. updates only mark the dashboard as changed, it is
+/// redrawn at most once per refresh interval and only the characters that changed since the last frame are written,
+/// so the cost of drawing doesn't depend on how fast posts come in. when the reports don't fit the terminal,
+/// each general is summed up in a single line instead
+class dashboard {
+public:
+    dashboard(std::ostream& os, std::chrono::milliseconds refresh_interval);
+    dashboard(const dashboard&) = delete;
+    dashboard& operator=(const dashboard&) = delete;
+    /// draws the last state once more and leaves it on the terminal, followed by the full reports if they didn't fit
+    ~dashboard();
+
+    /// the counters of a thread once it was ingested as a whole, replacing what it counted before. may be called from any thread
+    void update(const dpt::target& target, const dpt::statistics& stats);
+    /// replaces every general with the result of a whole collection
+    void update(const std::vector<dpt::general>& generals);
+private:
+    using thread_key = std::pair<std::string, unsigned int>; // board, thread no
+    struct live_general {
+        std::string name;
+        std::string board;
+        std::map<thread_key, dpt::statistics> threads;
+    };
+
+    live_general& find(const dpt::target& target);
+    std::vector<std::string> render(bool compact);
+    /// returns false if the full reports didn't fit the terminal
+    bool draw();
+    void run();
+
+    std::ostream& os;
+    const std::chrono::milliseconds refresh_interval;
+    toolbox::terminal::screen screen;
+    std::vector<live_general> generals;
+    bool changed;
+    bool stopping;
+    std::mutex mutex;
+    std::condition_variable stop_signal;
+    std::thread thread;
+};
+} // namespace dpt
@@ -0,0 +1,265 @@
+#include "dpt_definitions.hpp"
+#include <cstdint>
+#include <fstream>
+#include "hash_toolbox.hpp"
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#define BOOST_JSON_STANDALONE
+#include "boost/json.hpp"
+
+namespace {
+using namespace dpt;
+
+namespace tables {
+const search_values programming_languages = {
+    {"ALGOL"        , {"algol"                           }, policy_standard},
+    {"ActionScript" , {"actionscript"                    }, policy_standard},
+    {"Assembly"     , {"assembly", "assembler"           }, policy_standard},
+    {"B#"           , {"b#"                              }, policy_standard},
+    {"Bash"         , {"bash"                            }, policy_standard},
+    {"Batch"        , {"batch"                           }, policy_standard},
+    {"C++"          , {"c++", "cpp", "sepples", "seppels"}, policy_standard},
+    {"C#"           , {"c#"                              }, policy_standard},
+    {"Clojure"      , {"clojure"                         }, policy_standard, {"clojurescript"}},
+    {"ClojureScript", {"clojurescript"                   }, policy_standard},
+    {"COBOL"        , {"cobol"                           }, policy_standard},
+    {"CoffeeScript" , {"coffeescript"                    }, policy_standard},
+    {"CSS"          , {"css"                             }, policy_standard},
+    {"DCL"          , {"dcl"                             }, policy_standard},
+    {"Delphi"       , {"delphi"                          }, policy_standard},
+    {"Elixir"       , {"elixir"                          }, policy_standard},
+    {"Erlang"       , {"erlang"                          }, policy_standard},
+    {"F#"           , {"f#"                              }, policy_standard},
+    {"Forth"        , {"forth"                           }, policy_substring_risk},
+    {"Fortran"      , {"fortran"                         }, policy_standard},
+    {"GLSL"         , {"glsl"                            }, policy_standard},
+    {"Golang"       , {"golang"                          }, policy_standard},
+    {"Haskell"      , {"haskell"                         }, policy_standard},
+    {"HolyC"        , {"holyc"                           }, policy_standard},
+    {"HTML"         , {"html"                            }, policy_standard},
+    {"J#"           , {"j#"                              }, policy_standard},
+    {"J++"          , {"j++"                             }, policy_standard},
+    {"Java"         , {"java"                            }, policy_standard, {"javascript"}},
+    {"JavaScript"   , {"javascript", "js"                }, policy_substring_risk},
+    {"Kotlin"       , {"kotlin"                          }, policy_standard},
+    {"Lisp"         , {"lisp"                            }, policy_standard},
+    {"Machine code" , {"machine code"                    }, policy_standard},
+    {"MATLAB"       , {"matlab"                          }, policy_standard},
+    {"XML"          , {"xml"                             }, policy_standard},
+    {"Objective-C"  , {"objective-c", "object-c"         }, policy_standard},
+    {"OCaml"        , {"ocaml"                           }, policy_standard},
+    {"Opal"         , {"opal"                            }, policy_standard},
+    {"Pascal"       , {"pascal"                          }, policy_standard},
+    {"PHP"          , {"php"                             }, policy_standard},
+    {"PostScript"   , {"postscript"                      }, policy_standard},
+    {"PowerShell"   , {"powershell"                      }, policy_standard},
+    {"Pro*C"        , {"pro*c"                           }, policy_standard},
+    {"Python"       , {"python"                          }, policy_standard},
+    {"R++"          , {"r++"                             }, policy_standard},
+    {"Racket"       , {"racket"                          }, policy_standard},
+    {"Ruby"         , {"ruby"                            }, policy_standard},
+    {"Rust"         , {"rust"                            }, policy_standard},
+    {"Scala"        , {"scala"                           }, policy_standard},
+    {"Scheme"       , {"Scheme"                          }, policy_case_sensitive},
+    {"Smalltalk"    , {"smalltalk"                       }, policy_standard},
+    {"SQL"          , {"sql"                             }, policy_standard},
+    {"Swift"        , {"swift"                           }, policy_standard},
+    {"TypeScript"   , {"typescript"                      }, policy_standard},
+    {"VHDL"         , {"vhdl"                            }, policy_standard},
+    {"Zig"          , {"zig"                             }, policy_substring_risk},
+    {"Lua"          , {"lua"                             }, policy_substring_risk},
+    {"Ada"          , {"ada"                             }, policy_substring_risk},
+    {"Nim"          , {"nim"                             }, policy_substring_risk},
+    {"Perl"         , {"perl"                            }, policy_substring_risk},
+    {"Unity"        , {"unity"                           }, policy_substring_risk},
+    {"C"            , {"c", "C"                          }, policy_single_letter},
+    {"B"            , {"B"                               }, policy_single_letter},
+    {"D"            , {"D"                               }, policy_single_letter},
+    {"J"            , {"J"                               }, policy_single_letter},
+    {"R"            , {"R"                               }, policy_single_letter},
+    {"BASIC"        , {"BASIC"                           }, policy_case_sensitive},
+    {"Go"           , {"Go"                              }, policy_case_sensitive}
+};
+const search_values memes = {
+    {"\"In Haskell, this is just ...\""                 , {"in haskell this is just"                  }, policy_sentence},
+    {"\"In Lisp, this is just ...\""                    , {"in lisp this is just"                     }, policy_sentence},
+    {"\"... is the most powerful programming language\"", {"is the most powerful programming language"}, policy_sentence},
+    {"\"First for ...\""                                , {"first for"                                }, policy_sentence},
+    {"\"nth for ...\""                                  , {"nth for"                                  }, policy_sentence},
+    {"The word \"algorithm\" and nothing else"          , {"algorithm"                                }, policy_single_word}
+};
+const search_values topics = {
+    {"SICP"                  , {"sicp"              }, policy_substring_risk},
+    {"OOP/POO"               , {"oop", "poo"        }, policy_substring_risk},
+    {"Functional programming", {"functional", "fp"  }, policy_substring_risk},
+    {"Autism"                , {"autism", "autistic"}, policy_standard},
+    {"Design patterns"       , {"design pattern"    }, policy_standard},
+    {"Anime"                 , {"anime", "weeb"     }, policy_standard},
+    {"CMake"                 , {"cmake"             }, policy_standard},
+    {"Makefiles"             , {"makefile"          }, policy_standard},
+    {"Monads"                , {"monad"             }, policy_standard},
+    {"SOLID"                 , {"SOLID"             }, policy_case_sensitive},
+    {"OpenGL"                , {"opengl"            }, policy_standard},
+    {"Metaprogramming"       , {"metaprogramming"   }, policy_standard},
+    {"Vulkan"                , {"vulkan"            }, policy_standard}
+};
+const search_values programming_jokes = {
+    {"Fizz"       , {"fizz"       }, (policy_standard &~ policy_unique) | policy_count_all ,      {"fizzbuzz"}},
+    {"Buzz"       , {"buzz"       }, (policy_standard &~ policy_unique) | policy_count_all ,      {"fizzbuzz"}},
+    {"FizzBuzz"   , {"fizzbuzz"   }, (policy_standard &~ policy_unique) | policy_count_all},
+    {"Foo"        , {"foo"        }, (policy_substring_risk &~ policy_unique) | policy_count_all, {"foobar"}},
+    {"Bar"        , {"bar"        }, (policy_substring_risk &~ policy_unique) | policy_count_all, {"foobar"}},
+    {"FooBar"     , {"foobar"     }, (policy_standard &~ policy_unique) | policy_count_all},
+    {"Hello World", {"hello world"}, (policy_sentence &~ policy_unique) | policy_count_all}
+};
+const search_values insults = {
+    {"Cniles"        , {"cnile", "c-nile"              }, policy_standard},
+    {"Transsexuals"  , {"tranny", "trannie"            }, policy_standard},
+    {"Gays"          , {"fag", "faggot", "gay"         }, policy_standard},
+    {"Codemonkeys"   , {"codemonkey", "code-monkey"    }, policy_standard},
+    {"Brainlets"     , {"brainlet", "retard"           }, policy_standard},
+    {"Virgins"       , {"virgin"                       }, policy_standard},
+    {"Indians"       , {"pajeet", "curry", "poo in loo"}, policy_standard},
+    {"Indians"       , {"poos"                         }, policy_substring_risk},
+    {"Blacks"        , {"nigger"                       }, policy_standard},
+    {"Asians"        , {"chink"                        }, policy_standard},
+    {"Web developers", {"webshit"                      }, policy_standard}
+};
+
+const search_values buzzwords = {
+    {"Based"  , {"based" }, policy_standard},
+    {"Seethe" , {"seeth" }, policy_standard},
+    {"Cringe" , {"cringe"}, policy_standard}
+};
+} // namespace tables
+
+int policy_from_string(std::string_view name) {
+    static const std::vector<std::pair<std::string_view, int>> policies = {
+        {"no_transform"  , policy_no_transform  },
+        {"lowercase"     , policy_lowercase     },
+        {"no_punctuation", policy_no_punctuation},
+        {"simple_count"  , policy_simple_count  },
+        {"count_helper"  , policy_count_helper  },
+        {"exact_match"   , policy_exact_match   },
+        {"unique"        , policy_unique        },
+        {"count_all"     , policy_count_all     },
+        {"standard"      , policy_standard      },
+        {"case_sensitive", policy_case_sensitive},
+        {"substring_risk", policy_substring_risk},
+        {"single_letter" , policy_single_letter },
+        {"sentence"      , policy_sentence      },
+        {"single_word"   , policy_single_word   }
+    };
+    for (const auto& [policy_name, policy] : policies) {
+        if (policy_name == name) {
+            return policy;
+        }
+    }
+    throw std::runtime_error("unknown search policy \"" + std::string(name) + "\"");
+}
+std::vector<std::string> strings_from_json(const boost::json::object& obj, std::string_view field) {
+    std::vector<std::string> strings;
+    if (const auto* arr = obj.if_contains(field)) {
+        for (const auto& str : arr->as_array()) {
+            strings.emplace_back(str.as_string());
+            if (strings.back().empty()) {
+                throw std::runtime_error("empty string in \"" + std::string(field) + "\"");
+            }
+        }
+    }
+    return strings;
+}
+/// "policies" is a list of policy names applied in order, a name prefixed with '~' removes that policy again
+search_values search_values_from_json(const boost::json::object& root, std::string_view category) {
+    search_values values;
+    if (const auto* arr = root.if_contains(category)) {
+        for (const auto& val : arr->as_array()) {
+            const auto& obj = val.as_object();
+            int policies = 0;
+            for (const auto& policy : obj.at("policies").as_array()) {
+                std::string_view name = policy.as_string();
+                if (!name.empty() && name.front() == '~') {
+                    policies &= ~policy_from_string(name.substr(1));
+                } else {
+                    policies |= policy_from_string(name);
+                }
+            }
+            auto tokens = strings_from_json(obj, "tokens");
+            if (tokens.empty()) {
+                throw std::runtime_error("definition without tokens in \"" + std::string(category) + "\"");
+            }
+            values.emplace_back(obj.at("key").as_string(), tokens, policies, strings_from_json(obj, "occurs_in"));
+        }
+    }
+    return values;
+}
+
+void hash_helper(std::uint64_t& hash, std::string_view str) {
+    hash = toolbox::hash::fnv1a(str, hash);
+    hash = toolbox::hash::fnv1a("\xff", hash); // terminator, so {"ab", "c"} and {"a", "bc"} differ
+}
+void hash_helper(std::uint64_t& hash, const search_values& values) {
+    for (const auto& val : values) {
+        hash_helper(hash, val.key);
+        for (const auto& token : val.tokens) {
+            hash_helper(hash, token);
+        }
+        hash_helper(hash, std::to_string(val.policies));
+        for (const auto& token : val.occurs_in) {
+            hash_helper(hash, token);
+        }
+        hash_helper(hash, "");
+    }
+    hash_helper(hash, "");
+}
+} // namespace
+
+namespace dpt {
+std::uint64_t definitions::version() const {
+    std::uint64_t hash = toolbox::hash::fnv1a_offset_basis;
+    for (const auto* values : {&programming_languages, &memes, &topics, &programming_jokes, &insults, &buzzwords}) {
+        hash_helper(hash, *values);
+    }
+    return hash;
+}
+
+const definitions& definitions::builtin() {
+    static const definitions defs {
+        tables::programming_languages,
+        tables::memes,
+        tables::topics,
+        tables::programming_jokes,
+        tables::insults,
+        tables::buzzwords
+    };
+    return defs;
+}
+
+definitions definitions::from_file(const std::string& path) {
+    std::ifstream file {path};
+    if (!file) {
+        throw std::runtime_error("could not open definitions file " + path);
+    }
+    std::stringstream ss;
+    ss << file.rdbuf();
+    try {
+        boost::json::value val = boost::json::parse(ss.str());
+        const auto& root = val.as_object();
+        return definitions {
+            search_values_from_json(root, "programming_languages"),
+            search_values_from_json(root, "memes"),
+            search_values_from_json(root, "topics"),
+            search_values_from_json(root, "programming_jokes"),
+            search_values_from_json(root, "insults"),
+            search_values_from_json(root, "buzzwords")
+        };
+    } catch (const std::exception& e) {
+        throw std::runtime_error(path + ": " + e.what());
+    }
+}
+} // namespace dpt
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace dpt {
+enum search_policy {
+    policy_no_transform     = 1 << 0,
+    policy_lowercase        = 1 << 1,
+    policy_no_punctuation   = 1 << 2,
+    policy_simple_count     = 1 << 3,
+    policy_count_helper     = 1 << 4,
+    policy_exact_match      = 1 << 5,
+    policy_unique           = 1 << 6,
+    policy_count_all        = 1 << 7
+};
+constexpr int policy_standard       = (policy_lowercase | policy_simple_count | policy_unique);
+constexpr int policy_case_sensitive = (policy_no_punctuation | policy_count_helper | policy_unique);
+constexpr int policy_substring_risk = (policy_lowercase | policy_no_punctuation | policy_count_helper | policy_unique);
+constexpr int policy_single_letter  = (policy_no_transform | policy_count_helper | policy_unique);
+constexpr int policy_sentence       = (policy_lowercase | policy_no_punctuation | policy_simple_count | policy_unique);
+constexpr int policy_single_word    = (policy_lowercase | policy_no_punctuation | policy_exact_match | policy_unique);
+
+struct search_value {
+    search_value(std::string_view key, const std::vector<std::string>& tokens, int policies, const std::vector<std::string>& occurs_in)
+    : key{key}, tokens{tokens}, policies{policies}, occurs_in{occurs_in} {}
+    search_value(std::string_view key, const std::vector<std::string>& tokens, int policies)
+    : search_value{key, tokens, policies, {}} {}
+
+    const std::string key;
+    const std::vector<std::string> tokens;
+    const int policies;
+    const std::vector<std::string> occurs_in;
+};
+using search_values = std::vector<search_value>;
+
+struct definitions {
+    search_values programming_languages;
+    search_values memes;
+    search_values topics;
+    search_values programming_jokes;
+    search_values insults;
+    search_values buzzwords;
+
+    /// hash over every definition, changes whenever the analysis results could change
+    std::uint64_t version() const;
+
+    /// the tables dptstat was originally compiled with, used when no definitions file is given
+    static const definitions& builtin();
+    /// throws std::runtime_error if the file can't be read or contains invalid definitions
+    static definitions from_file(const std::string& path);
+};
+} // namespace dpt
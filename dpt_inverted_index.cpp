@@ -0,0 +1,211 @@
+#include <algorithm>
+#include "binary_toolbox.hpp"
+#include <cctype>
+#include <cstdint>
+#include "dpt_inverted_index.hpp"
+#include <filesystem>
+#include <fstream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+namespace {
+constexpr std::uint64_t index_magic = 0x3158444e49504400ull; // "\0DPINDX1"
+constexpr std::uint32_t index_format_version = 1;
+
+bool is_separator(char c) {
+    switch(c) {
+    case '+':
+    case '-':
+    case '*':
+    case '#':
+        return false;
+    default:
+        return std::isspace(static_cast<unsigned char>(c)) || std::ispunct(static_cast<unsigned char>(c));
+    }
+}
+bool occurrence_less(const dpt::inverted_index::occurrence& lhs, const dpt::inverted_index::occurrence& rhs) {
+    return (lhs.post_no < rhs.post_no) || ((lhs.post_no == rhs.post_no) && (lhs.position < rhs.position));
+}
+} // namespace
+
+namespace dpt {
+inverted_index::inverted_index(unsigned int thread_no) : thread_no{thread_no}, postings{} {}
+
+std::vector<std::string> inverted_index::tokenize(std::string_view text) {
+    std::vector<std::string> tokens;
+    std::string token;
+    for (char c : text) {
+        if (is_separator(c)) {
+            if (!token.empty()) {
+                tokens.push_back(std::move(token));
+                token.clear();
+            }
+        } else {
+            token += static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        }
+    }
+    if (!token.empty()) {
+        tokens.push_back(std::move(token));
+    }
+    return tokens;
+}
+
+void inverted_index::add(std::uint64_t post_no, std::string_view text) {
+    auto tokens = tokenize(text);
+    for (std::uint32_t position = 0; position < tokens.size(); ++position) {
+        auto it = postings.find(tokens[position]);
+        if (it == postings.end()) {
+            it = postings.emplace(std::move(tokens[position]), term_postings{}).first;
+        }
+        auto& term = it->second;
+        if ((post_no < term.last_post) || ((post_no == term.last_post) && (position < term.last_position))) {
+            throw std::invalid_argument("posts have to be indexed once each, in ascending order");
+        }
+        const std::uint64_t post_delta = post_no - term.last_post;
+        toolbox::binary::append_varint(term.data, post_delta);
+        toolbox::binary::append_varint(term.data, (post_delta == 0) ? (position - term.last_position) : position);
+        term.last_post = post_no;
+        term.last_position = position;
+        ++term.count;
+    }
+}
+
+std::vector<inverted_index::occurrence> inverted_index::decode(const term_postings& term) const {
+    std::vector<occurrence> occurrences;
+    occurrences.reserve(term.count);
+    const std::uint8_t* it = term.data.data();
+    const std::uint8_t* end = it + term.data.size();
+    std::uint64_t post_no = 0;
+    std::uint64_t position = 0;
+    std::uint64_t post_delta, position_value;
+    while (toolbox::binary::read_varint(it, end, post_delta) && toolbox::binary::read_varint(it, end, position_value)) {
+        post_no += post_delta;
+        position = (post_delta == 0) ? position + position_value : position_value;
+        occurrences.push_back({post_no, static_cast<std::uint32_t>(position)});
+    }
+    return occurrences;
+}
+
+std::vector<inverted_index::occurrence> inverted_index::find(std::string_view phrase) const {
+    auto tokens = tokenize(phrase);
+    if (tokens.empty()) {
+        return {};
+    }
+    std::vector<std::vector<occurrence>> token_occurrences;
+    for (const auto& token : tokens) {
+        auto it = postings.find(token);
+        if (it == postings.end()) {
+            return {};
+        }
+        token_occurrences.push_back(decode(it->second));
+    }
+
+    std::vector<occurrence> matches;
+    for (const auto& first : token_occurrences.front()) {
+        bool match = true;
+        for (std::size_t i = 1; (i < token_occurrences.size()) && match; ++i) {
+            const occurrence next {first.post_no, first.position + static_cast<std::uint32_t>(i)};
+            match = std::binary_search(token_occurrences[i].begin(), token_occurrences[i].end(), next, occurrence_less);
+        }
+        if (match) {
+            matches.push_back(first);
+        }
+    }
+    return matches;
+}
+
+std::size_t inverted_index::count_posts(const std::vector<occurrence>& occurrences) {
+    std::size_t n = 0;
+    for (std::size_t i = 0; i < occurrences.size(); ++i) {
+        if ((i == 0) || (occurrences[i].post_no != occurrences[i - 1].post_no)) {
+            ++n;
+        }
+    }
+    return n;
+}
+
+unsigned int inverted_index::thread() const {
+    return thread_no;
+}
+
+std::size_t inverted_index::size() const {
+    return postings.size();
+}
+
+bool inverted_index::save(const std::string& path) const {
+    using toolbox::binary::write;
+
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path{path}.parent_path(), ec);
+    return toolbox::binary::write_file_atomically(path, [this](std::ostream& file) {
+        write(file, index_magic);
+        write(file, index_format_version);
+        write(file, static_cast<std::uint32_t>(thread_no));
+        write(file, static_cast<std::uint64_t>(postings.size()));
+        for (const auto& [token, term] : postings) {
+            write(file, token);
+            write(file, term.count);
+            write(file, std::string_view{reinterpret_cast<const char*>(term.data.data()), term.data.size()});
+        }
+    });
+}
+
+inverted_index inverted_index::load(const std::string& path) {
+    using toolbox::binary::read;
+
+    std::ifstream file {path, std::ios::binary};
+    std::uint64_t magic{0};
+    std::uint32_t format_version{0};
+    std::uint32_t thread_no{0};
+    std::uint64_t n_terms{0};
+    if (!read(file, magic) || !read(file, format_version) || !read(file, thread_no) || !read(file, n_terms)
+        || (magic != index_magic) || (format_version != index_format_version)) {
+        throw std::runtime_error(path + " is not a dptstat index");
+    }
+    inverted_index index {thread_no};
+    for (std::uint64_t i = 0; i < n_terms; ++i) {
+        std::string token;
+        std::string data;
+        term_postings term{};
+        if (!read(file, token) || !read(file, term.count) || !read(file, data)) {
+            throw std::runtime_error(path + " is truncated");
+        }
+        term.data.assign(data.begin(), data.end());
+        index.postings.emplace(std::move(token), std::move(term));
+    }
+    return index;
+}
+
+std::string index_path(const std::string& index_dir, std::string_view board, unsigned int thread_no) {
+    return (std::filesystem::path{index_dir} / std::string(board) / (std::to_string(thread_no) + ".idx")).string();
+}
+
+std::vector<dpt::inverted_index> load_indexes(const std::vector<std::string>& paths) {
+    namespace fs = std::filesystem;
+
+    std::vector<std::string> files;
+    for (const auto& path : paths) {
+        if (fs::is_directory(path)) {
+            for (const auto& entry : fs::recursive_directory_iterator(path)) {
+                if (entry.is_regular_file() && (entry.path().extension() == ".idx")) {
+                    files.push_back(entry.path().string());
+                }
+            }
+        } else {
+            files.push_back(path);
+        }
+    }
+    std::sort(files.begin(), files.end());
+
+    std::vector<dpt::inverted_index> indexes;
+    for (const auto& file : files) {
+        indexes.push_back(inverted_index::load(file));
+    }
+    return indexes;
+}
+} // namespace dpt
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace dpt {
+/// normalized token -> postings of a single thread. tokens are lowercase words, punctuation other than + - * #
+/// separates words like the sentence search policy does. postings are stored as varint encoded deltas
+class inverted_index {
+public:
+    struct occurrence {
+        std::uint64_t post_no;
+        std::uint32_t position; // token index within the post
+    };
+
+    explicit inverted_index(unsigned int thread_no);
+
+    static std::vector<std::string> tokenize(std::string_view text);
+
+    /// posts have to be added once each, in ascending post number order
+    void add(std::uint64_t post_no, std::string_view text);
+
+    /// every occurrence of a phrase of one or more tokens, as the position of its first token
+    std::vector<occurrence> find(std::string_view phrase) const;
+    /// number of distinct posts among occurrences
+    static std::size_t count_posts(const std::vector<occurrence>& occurrences);
+    unsigned int thread() const;
+    std::size_t size() const;
+
+    bool save(const std::string& path) const;
+    /// throws std::runtime_error if the file can't be read
+    static inverted_index load(const std::string& path);
+private:
+    struct term_postings {
+        std::vector<std::uint8_t> data{};
+        std::uint64_t last_post{0};
+        std::uint32_t last_position{0};
+        std::uint32_t count{0};
+    };
+    std::vector<occurrence> decode(const term_postings& postings) const;
+
+    unsigned int thread_no;
+    std::map<std::string, term_postings, std::less<>> postings;
+};
+
+/// <index_dir>/<board>/<thread no>.idx
+std::string index_path(const std::string& index_dir, std::string_view board, unsigned int thread_no);
+/// every .idx file below the paths, throws std::runtime_error if one can't be read
+std::vector<dpt::inverted_index> load_indexes(const std::vector<std::string>& paths);
+} // namespace dpt
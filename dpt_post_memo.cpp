@@ -0,0 +1,134 @@
+#include "analyse_dpt.hpp"
+#include "binary_toolbox.hpp"
+#include <cstdint>
+#include "dpt_post_memo.hpp"
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <tuple>
+#include <utility>
+
+namespace {
+constexpr std::uint64_t memo_magic = 0x314f4d4554504400ull; // "\0DPTEMO1"
+constexpr std::uint32_t memo_format_version = 2; // bump whenever the matcher layout changes
+} // namespace
+
+namespace dpt {
+post_memo::post_memo() : entries{}, mutex{} {}
+
+bool post_memo::load(const std::string& path) {
+    using toolbox::binary::read;
+
+    std::error_code ec;
+    const std::uint64_t file_size = std::filesystem::file_size(path, ec);
+    if (ec) {
+        return false;
+    }
+    std::ifstream file {path, std::ios::binary};
+    std::uint64_t magic{0};
+    std::uint32_t format_version{0};
+    std::uint64_t n_entries{0};
+    if (!read(file, magic) || !read(file, format_version) || !read(file, n_entries) || (magic != memo_magic) || (format_version != memo_format_version)) {
+        return false;
+    }
+    constexpr std::uint64_t increment_size = sizeof(std::uint32_t) + sizeof(std::uint64_t);
+
+    std::map<key_t, entry, std::less<>> loaded_entries;
+    for (std::uint64_t i = 0; i < n_entries; ++i) {
+        std::string board;
+        std::uint64_t thread_no, post_no, version;
+        std::uint32_t n_increments;
+        entry e {{}, false};
+        if (!read(file, board) || !read(file, thread_no) || !read(file, post_no) || !read(file, version) || !read(file, e.result.n_code_snippets) || !read(file, n_increments)) {
+            return false;
+        }
+        // a corrupt count mustn't allocate more than the rest of the file could hold
+        if (n_increments > (file_size - static_cast<std::uint64_t>(file.tellg())) / increment_size) {
+            return false;
+        }
+        e.result.increments.resize(n_increments);
+        for (auto& [value_index, amount] : e.result.increments) {
+            if (!read(file, value_index) || !read(file, amount)) {
+                return false;
+            }
+        }
+        loaded_entries.emplace(key_t{std::move(board), thread_no, post_no, version}, std::move(e));
+    }
+    entries = std::move(loaded_entries);
+    return true;
+}
+
+bool post_memo::save(const std::string& path) const {
+    using toolbox::binary::write;
+
+    return toolbox::binary::write_file_atomically(path, [this](std::ostream& file) {
+        write(file, memo_magic);
+        write(file, memo_format_version);
+        write(file, static_cast<std::uint64_t>(entries.size()));
+        for (const auto& [key, e] : entries) {
+            const auto& [board, thread_no, post_no, version] = key;
+            write(file, board);
+            write(file, thread_no);
+            write(file, post_no);
+            write(file, version);
+            write(file, e.result.n_code_snippets);
+            write(file, static_cast<std::uint32_t>(e.result.increments.size()));
+            for (const auto& [value_index, amount] : e.result.increments) {
+                write(file, value_index);
+                write(file, amount);
+            }
+        }
+    });
+}
+
+const dpt::matcher::match_result* post_memo::find(std::string_view board, std::uint64_t thread_no, std::uint64_t post_no, std::uint64_t version) {
+    std::lock_guard lock {mutex};
+    auto it = entries.find(std::tuple{board, thread_no, post_no, version});
+    if (it == entries.end()) {
+        return nullptr;
+    }
+    it->second.used = true;
+    return &it->second.result;
+}
+
+void post_memo::store(std::string_view board, std::uint64_t thread_no, std::uint64_t post_no, std::uint64_t version, dpt::matcher::match_result result) {
+    std::lock_guard lock {mutex};
+    entries.insert_or_assign(key_t{board, thread_no, post_no, version}, entry{std::move(result), true});
+}
+
+void post_memo::touch(std::string_view board, std::uint64_t thread_no, std::uint64_t version) {
+    std::lock_guard lock {mutex};
+    for (auto it = entries.lower_bound(std::tuple{board, thread_no, std::uint64_t{0}, std::uint64_t{0}}); it != entries.end(); ++it) {
+        const auto& [entry_board, entry_thread_no, post_no, entry_version] = it->first;
+        if ((entry_board != board) || (entry_thread_no != thread_no)) {
+            break;
+        }
+        if (entry_version == version) {
+            it->second.used = true;
+        }
+    }
+}
+
+std::size_t post_memo::prune() {
+    std::size_t n_pruned = 0;
+    for (auto it = entries.begin(); it != entries.end();) {
+        if (!it->second.used) {
+            it = entries.erase(it);
+            ++n_pruned;
+        } else {
+            it->second.used = false;
+            ++it;
+        }
+    }
+    return n_pruned;
+}
+
+std::size_t post_memo::size() const {
+    return entries.size();
+}
+} // namespace dpt
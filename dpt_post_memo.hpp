@@ -0,0 +1,41 @@
+#pragma once
+
+#include "analyse_dpt.hpp"
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <tuple>
+
+namespace dpt {
+/// persisted match results of every analysed post, post numbers are only unique per board. posts can't be edited so a result stays valid
+/// for as long as the definitions it was computed with (matcher::version()) stay the same.
+/// find and store may be called concurrently, load, save and prune may not
+class post_memo {
+public:
+    post_memo();
+
+    /// a missing or unreadable memo file leaves the memo empty
+    bool load(const std::string& path);
+    bool save(const std::string& path) const;
+
+    const dpt::matcher::match_result* find(std::string_view board, std::uint64_t thread_no, std::uint64_t post_no, std::uint64_t version);
+    void store(std::string_view board, std::uint64_t thread_no, std::uint64_t post_no, std::uint64_t version, dpt::matcher::match_result result);
+    /// keeps the entries of a thread that wasn't downloaded, e.g. because it was restored unchanged, from being pruned
+    void touch(std::string_view board, std::uint64_t thread_no, std::uint64_t version);
+    /// drops every entry that wasn't found or stored since the last prune, i.e. posts of threads that died
+    /// and results computed with definitions that are no longer active
+    std::size_t prune();
+    std::size_t size() const;
+private:
+    using key_t = std::tuple<std::string, std::uint64_t, std::uint64_t, std::uint64_t>; // board, thread no, post no, version
+    struct entry {
+        dpt::matcher::match_result result;
+        bool used;
+    };
+    std::map<key_t, entry, std::less<>> entries; // looked up without copying the board
+    std::mutex mutex;
+};
+} // namespace dpt
@@ -0,0 +1,156 @@
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include "dpt_definitions.hpp"
+#include "dpt_reference_engine.hpp"
+#include "dpt_thread_statistics.hpp"
+#include <string>
+#include "string_toolbox.hpp"
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace {
+char remove_punctuation_helper(char c) {
+    switch(c) {
+    case '+':
+    case '-':
+    case '*':
+    case '#':
+        return c;
+    default:
+        if (ispunct(c)) {
+            return ' ';
+        } else {
+            return c;
+        }
+    }
+}
+std::size_t count_helper(std::string_view&& post, const std::string& language) {
+    constexpr std::array begin_separators = {" ", "("};
+    constexpr std::array end_separators = {" ", "-", ",", ".", "?", "!", ")", "\"", "\"", "s", "fag"};
+    std::size_t n = 0;
+    for (auto begin_separator : begin_separators) {
+        for (auto end_separator : end_separators) {
+            n += toolbox::string::count(post, begin_separator + language + end_separator);
+        }
+    }
+    if (toolbox::string::ends_with(post, " " + language) || toolbox::string::starts_with(post, language + " ")) {
+        ++n;
+    }
+    return n;
+}
+std::size_t search_helper(dpt::statistics::mentions_counter& mentions, std::string post, const dpt::search_value& search_val) {
+    if (!(search_val.policies & dpt::policy_no_transform)) {
+        if (search_val.policies & dpt::policy_lowercase) {
+            std::transform(post.begin(), post.end(), post.begin(), [](char c){ return std::tolower(c); });
+        }
+        if (search_val.policies & dpt::policy_no_punctuation) {
+            std::transform(post.begin(), post.end(), post.begin(), remove_punctuation_helper);
+            post.erase(std::unique(post.begin(), post.end(), [](char lhs, char rhs){ return (lhs == rhs) && (lhs == ' '); }), post.end());
+        }
+    }
+
+    std::size_t occurences = 0;
+    for (const auto& token : search_val.tokens) {
+        if (search_val.policies & dpt::policy_simple_count) {
+            occurences += toolbox::string::count(post, token);
+        } else if (search_val.policies & dpt::policy_count_helper) {
+            occurences += count_helper(post, token);
+        } else if (search_val.policies & dpt::policy_exact_match) {
+            if (toolbox::string::trim(post) == token) {
+                occurences += 1;
+            }
+        } else {
+            //
+        }
+    }
+
+    for (const auto& token : search_val.occurs_in) {
+        occurences -= toolbox::string::count(post, token);
+    }
+
+    if (occurences != 0) {
+        if (search_val.policies & dpt::policy_unique) {
+            mentions[search_val.key] += 1;
+        } else if (search_val.policies & dpt::policy_count_all) {
+            mentions[search_val.key] += occurences;
+        } else {
+            //
+        }
+    }
+    return occurences;
+}
+} // namespace
+
+namespace dpt {
+namespace reference {
+dpt::statistics::post sanitize(std::string post, std::string_view board, std::uint64_t no) {
+    const std::vector<std::pair<std::string, std::string>> to_erase = {
+        {"<a href=\"#p", "</a>"},                       // quotelink
+        {"<a href=\"/" + std::string(board), "</a>"}    // threadlink
+    };
+
+    bool quotes = false;
+    bool quotes_op = false;
+    for (const auto& [begin_segment, end_segment] : to_erase) {
+        std::size_t p = std::string::npos;
+        while ((p = post.find(begin_segment)) != std::string::npos) {
+            quotes = true;
+            if (post.find("(OP)" + end_segment, p) != std::string::npos) {
+                quotes_op = true;
+            }
+            auto p_end = post.find(end_segment) + end_segment.size();
+            // the one change to the original, which never returned once an end segment ended right where the link begins
+            if ((p_end != std::string::npos) && (p_end != p)) {
+                post.erase(p, p_end - p);
+            } else {
+                break;
+            }
+        }
+    }
+    post = toolbox::string::replace(std::move(post), "<span class=\"quote\">&gt;", " "); // greentext
+    post = toolbox::string::replace(std::move(post), "</span>", " ");
+    post = toolbox::string::replace(std::move(post), "<br>", " ");
+    post = toolbox::string::replace(std::move(post), "&#039;", "'");
+    post = toolbox::string::replace(std::move(post), "&quot;", "\"");
+    post = toolbox::string::trim(std::move(post));
+
+    return {post, quotes, quotes_op, no};
+}
+
+void analyse(dpt::statistics& stats, const dpt::statistics::post& post, const dpt::definitions& defs) {
+    for (const auto& search_val : defs.programming_languages) {
+        search_helper(stats.language_mentions, post.text, search_val);
+        if (!post.quotes || post.quotes_op) {
+            for (const auto& token : search_val.tokens) {
+                search_value single_word_val {"The word \"" + token + "\" and nothing else", {token}, policy_single_word};
+                search_helper(stats.meme_posts, post.text, single_word_val);
+            }
+        }
+    }
+    for (const auto& search_val : defs.memes) {
+        search_helper(stats.meme_posts, post.text, search_val);
+    }
+    for (const auto& search_val : defs.topics) {
+        search_helper(stats.topic_discussions, post.text, search_val);
+    }
+    for (const auto& search_val : defs.insults) {
+        search_helper(stats.insults, post.text, search_val);
+    }
+    for (const auto& search_val : defs.programming_jokes) {
+        search_helper(stats.programming_jokes, post.text, search_val);
+    }
+    for (const auto& search_val : defs.buzzwords) {
+        search_helper(stats.buzzwords, post.text, search_val);
+    }
+    stats.n_code_snippets += toolbox::string::count(post.text, "class=\"prettyprint\"");
+}
+
+dpt::statistics::ingest_function analyser(const dpt::definitions& defs) {
+    return [defs](dpt::statistics& stats, const dpt::statistics::post& post) {
+        analyse(stats, post, defs);
+    };
+}
+} // namespace reference
+} // namespace dpt
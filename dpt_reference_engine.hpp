@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+#include "dpt_definitions.hpp"
+#include "dpt_thread_statistics.hpp"
+#include <string>
+#include <string_view>
+
+namespace dpt {
+/// the original, unoptimized sanitizer and matcher, kept exactly as they were so that faster engines can be
+/// verified against them. don't change the behaviour of anything in here, not even to fix a quirk
+namespace reference {
+/// sanitizes a post like statistics::add_post did, quotelinks and threadlinks to the board are removed
+dpt::statistics::post sanitize(std::string post, std::string_view board, std::uint64_t no = 0);
+/// adds the counters of a single post, every definition is searched on its own
+void analyse(dpt::statistics& stats, const dpt::statistics::post& post, const dpt::definitions& defs);
+/// analyse as a statistics::ingest_function
+dpt::statistics::ingest_function analyser(const dpt::definitions& defs);
+} // namespace reference
+} // namespace dpt
@@ -0,0 +1,341 @@
+#include <algorithm>
+#include "binary_toolbox.hpp"
+#include "collect_dpt.hpp"
+#include <cstdint>
+#include <cstring>
+#include "dpt_snapshot.hpp"
+#include "dpt_thread_statistics.hpp"
+#include <exception>
+#include "hash_toolbox.hpp"
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace {
+constexpr std::uint64_t snapshot_magic = 0x31504e5354504400ull; // "\0DPTSNP1"
+constexpr std::uint32_t snapshot_format_version = 1; // bump whenever a record or dpt::statistics_counters changes
+constexpr std::size_t n_counters = dpt::statistics_counters.size();
+
+struct header {
+    std::uint64_t magic;
+    std::uint32_t format_version;
+    std::uint32_t header_size;
+    std::uint64_t version;
+    std::uint64_t file_size;
+    std::uint64_t checksum; // fnv1a of everything after the header
+    std::uint64_t n_generals;
+    std::uint64_t n_threads;
+    std::uint64_t n_counter_records;
+    std::uint64_t strings_size;
+};
+struct string_ref {
+    std::uint32_t offset;
+    std::uint32_t size;
+};
+struct general_record {
+    string_ref name;
+    string_ref board;
+    std::uint32_t threads_begin;
+    std::uint32_t threads_end;
+};
+struct thread_record {
+    std::uint32_t general;
+    std::uint32_t id;
+    std::int64_t last_modified;
+    std::uint64_t n_code_snippets;
+    std::uint64_t n_ingested_posts;
+    string_ref board;
+    string_ref title;
+    string_ref timestamp;
+    std::uint32_t counters_begin[n_counters + 1]; // counter c of the thread is [counters_begin[c], counters_begin[c + 1])
+};
+struct counter_record {
+    string_ref key;
+    std::uint64_t mentions;
+};
+static_assert(std::is_trivially_copyable_v<header> && std::is_trivially_copyable_v<general_record>
+              && std::is_trivially_copyable_v<thread_record> && std::is_trivially_copyable_v<counter_record>);
+
+/// byte offsets of the sections, derived from the counts in the header
+struct layout {
+    explicit layout(const header& h)
+    : generals{align(sizeof(header))},
+      threads{align(generals + h.n_generals * sizeof(general_record))},
+      lookup{align(threads + h.n_threads * sizeof(thread_record))},
+      counters{align(lookup + h.n_threads * sizeof(std::uint32_t))},
+      strings{align(counters + h.n_counter_records * sizeof(counter_record))},
+      end{strings + h.strings_size} {}
+
+    static std::uint64_t align(std::uint64_t offset) {
+        return (offset + 7) & ~std::uint64_t{7};
+    }
+
+    std::uint64_t generals;
+    std::uint64_t threads;
+    std::uint64_t lookup;
+    std::uint64_t counters;
+    std::uint64_t strings;
+    std::uint64_t end;
+};
+
+template <typename Record>
+const Record* section_helper(const unsigned char* data, std::uint64_t offset) {
+    return reinterpret_cast<const Record*>(data + offset);
+}
+
+class snapshot_builder {
+public:
+    header h{};
+    std::vector<general_record> generals{};
+    std::vector<thread_record> threads{};
+    std::vector<counter_record> counters{};
+    std::string strings{};
+
+    string_ref add_string(std::string_view str) {
+        string_ref ref {static_cast<std::uint32_t>(strings.size()), static_cast<std::uint32_t>(str.size())};
+        strings += str;
+        return ref;
+    }
+    void add_thread(std::uint32_t general, const dpt::statistics& stats) {
+        thread_record record{};
+        record.general = general;
+        record.id = stats.id;
+        record.last_modified = stats.last_modified;
+        record.n_code_snippets = stats.n_code_snippets;
+        record.n_ingested_posts = stats.n_ingested_posts;
+        record.board = add_string(stats.board);
+        record.title = add_string(stats.title);
+        record.timestamp = add_string(stats.timestamp);
+        for (std::size_t c = 0; c < n_counters; ++c) {
+            record.counters_begin[c] = static_cast<std::uint32_t>(counters.size());
+            for (const auto& [key, mentions] : stats.*dpt::statistics_counters[c]) {
+                counters.push_back({add_string(key), static_cast<std::uint64_t>(mentions)});
+            }
+        }
+        record.counters_begin[n_counters] = static_cast<std::uint32_t>(counters.size());
+        threads.push_back(record);
+    }
+    std::string build(std::uint64_t version) {
+        h.magic = snapshot_magic;
+        h.format_version = snapshot_format_version;
+        h.header_size = sizeof(header);
+        h.version = version;
+        h.n_generals = generals.size();
+        h.n_threads = threads.size();
+        h.n_counter_records = counters.size();
+        h.strings_size = strings.size();
+        const layout l {h};
+        h.file_size = l.end;
+
+        std::vector<std::uint32_t> lookup(threads.size());
+        for (std::uint32_t i = 0; i < lookup.size(); ++i) {
+            lookup[i] = i;
+        }
+        std::sort(lookup.begin(), lookup.end(), [this](std::uint32_t lhs, std::uint32_t rhs) {
+            return key(lhs) < key(rhs);
+        });
+
+        std::string bytes(l.end, '\0');
+        copy(bytes, l.generals, generals.data(), generals.size() * sizeof(general_record));
+        copy(bytes, l.threads, threads.data(), threads.size() * sizeof(thread_record));
+        copy(bytes, l.lookup, lookup.data(), lookup.size() * sizeof(std::uint32_t));
+        copy(bytes, l.counters, counters.data(), counters.size() * sizeof(counter_record));
+        copy(bytes, l.strings, strings.data(), strings.size());
+        h.checksum = toolbox::hash::fnv1a(std::string_view{bytes}.substr(sizeof(header)));
+        copy(bytes, 0, &h, sizeof(header));
+        return bytes;
+    }
+private:
+    std::pair<std::uint32_t, std::string_view> key(std::uint32_t thread_index) const {
+        const auto& t = threads[thread_index];
+        return {t.id, std::string_view{strings}.substr(t.board.offset, t.board.size)};
+    }
+    static void copy(std::string& bytes, std::uint64_t offset, const void* src, std::size_t size) {
+        if (size != 0) {
+            std::memcpy(bytes.data() + offset, src, size);
+        }
+    }
+};
+} // namespace
+
+namespace dpt {
+bool snapshot::open(const std::string& path) {
+    if (!file.open(path) || (file.size() < sizeof(header))) {
+        file.close();
+        return false;
+    }
+    const auto& h = *section_helper<header>(file.data(), 0);
+    const layout l {h};
+    bool valid = (h.magic == snapshot_magic) && (h.format_version == snapshot_format_version) && (h.header_size == sizeof(header))
+        && (h.n_generals < file.size()) && (h.n_threads < file.size()) && (h.n_counter_records < file.size()) && (h.strings_size < file.size())
+        && (h.file_size == file.size()) && (l.end == file.size())
+        && (h.checksum == toolbox::hash::fnv1a(std::string_view{reinterpret_cast<const char*>(file.data()), file.size()}.substr(sizeof(header))));
+
+    // every reference is checked once here, so the accessors can read the records without checks
+    auto valid_string = [&](string_ref ref) {
+        return (std::uint64_t{ref.offset} + ref.size) <= h.strings_size;
+    };
+    const auto* generals = section_helper<general_record>(file.data(), l.generals);
+    const auto* threads = section_helper<thread_record>(file.data(), l.threads);
+    const auto* lookup = section_helper<std::uint32_t>(file.data(), l.lookup);
+    const auto* counters = section_helper<counter_record>(file.data(), l.counters);
+    for (std::uint64_t i = 0; valid && (i < h.n_generals); ++i) {
+        const auto& g = generals[i];
+        valid = valid_string(g.name) && valid_string(g.board) && (g.threads_begin <= g.threads_end) && (g.threads_end <= h.n_threads);
+    }
+    for (std::uint64_t i = 0; valid && (i < h.n_threads); ++i) {
+        const auto& t = threads[i];
+        valid = (t.general < h.n_generals) && valid_string(t.board) && valid_string(t.title) && valid_string(t.timestamp)
+            && (lookup[i] < h.n_threads) && (t.counters_begin[n_counters] <= h.n_counter_records)
+            && std::is_sorted(std::begin(t.counters_begin), std::end(t.counters_begin));
+    }
+    for (std::uint64_t i = 0; valid && (i < h.n_counter_records); ++i) {
+        valid = valid_string(counters[i].key);
+    }
+    if (!valid) {
+        file.close();
+    }
+    return valid;
+}
+
+void snapshot::close() {
+    file.close();
+}
+
+bool snapshot::is_open() const {
+    return file.is_open();
+}
+
+std::uint64_t snapshot::version() const {
+    return section_helper<header>(file.data(), 0)->version;
+}
+
+std::size_t snapshot::size() const {
+    return section_helper<header>(file.data(), 0)->n_threads;
+}
+
+std::vector<dpt::statistics> snapshot::threads(std::string_view general_name, std::string_view board) const {
+    const auto& h = *section_helper<header>(file.data(), 0);
+    const layout l {h};
+    const auto* generals = section_helper<general_record>(file.data(), l.generals);
+    const auto* strings = section_helper<char>(file.data(), l.strings);
+    auto str = [strings](string_ref ref) {
+        return std::string_view{strings + ref.offset, ref.size};
+    };
+
+    std::vector<dpt::statistics> result;
+    for (std::uint64_t i = 0; i < h.n_generals; ++i) {
+        if ((str(generals[i].name) == general_name) && (str(generals[i].board) == board)) {
+            for (std::uint32_t t = generals[i].threads_begin; t < generals[i].threads_end; ++t) {
+                result.push_back(restore(t));
+            }
+        }
+    }
+    return result;
+}
+
+std::optional<dpt::statistics> snapshot::find(std::string_view board, unsigned int id, std::int64_t last_modified) const {
+    const auto& h = *section_helper<header>(file.data(), 0);
+    const layout l {h};
+    const auto* threads = section_helper<thread_record>(file.data(), l.threads);
+    const auto* lookup = section_helper<std::uint32_t>(file.data(), l.lookup);
+    const auto* strings = section_helper<char>(file.data(), l.strings);
+
+    auto it = std::lower_bound(lookup, lookup + h.n_threads, id, [threads](std::uint32_t thread_index, unsigned int id) {
+        return threads[thread_index].id < id;
+    });
+    for (; (it != lookup + h.n_threads) && (threads[*it].id == id); ++it) {
+        const auto& t = threads[*it];
+        if ((std::string_view{strings + t.board.offset, t.board.size} == board) && (last_modified != 0) && (t.last_modified == last_modified)) {
+            return restore(*it);
+        }
+    }
+    return std::nullopt;
+}
+
+dpt::statistics snapshot::restore(std::size_t thread_index) const {
+    const auto& h = *section_helper<header>(file.data(), 0);
+    const layout l {h};
+    const auto& t = section_helper<thread_record>(file.data(), l.threads)[thread_index];
+    const auto* counters = section_helper<counter_record>(file.data(), l.counters);
+    const auto* strings = section_helper<char>(file.data(), l.strings);
+    auto str = [strings](string_ref ref) {
+        return std::string_view{strings + ref.offset, ref.size};
+    };
+
+    dpt::statistics stats {t.id, str(t.board), str(t.title), str(t.timestamp)};
+    stats.last_modified = t.last_modified;
+    stats.n_code_snippets = t.n_code_snippets;
+    stats.n_ingested_posts = t.n_ingested_posts;
+    for (std::size_t c = 0; c < n_counters; ++c) {
+        auto& counter = stats.*statistics_counters[c];
+        for (std::uint32_t i = t.counters_begin[c]; i < t.counters_begin[c + 1]; ++i) {
+            counter.emplace_hint(counter.end(), str(counters[i].key), counters[i].mentions);
+        }
+    }
+    return stats;
+}
+
+bool snapshot::save(const std::string& path, std::uint64_t version, const std::vector<dpt::general>& generals) {
+    snapshot_builder builder{};
+    for (const auto& gen : generals) {
+        general_record record{};
+        record.name = builder.add_string(gen.target.name);
+        record.board = builder.add_string(gen.target.board);
+        record.threads_begin = static_cast<std::uint32_t>(builder.threads.size());
+        for (const auto& stats : gen.threads) {
+            builder.add_thread(static_cast<std::uint32_t>(builder.generals.size()), stats);
+        }
+        record.threads_end = static_cast<std::uint32_t>(builder.threads.size());
+        builder.generals.push_back(record);
+    }
+    const std::string bytes = builder.build(version);
+
+    return toolbox::binary::write_file_atomically(path, [&bytes](std::ostream& file) {
+        file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    });
+}
+
+snapshot_writer::snapshot_writer(std::string path)
+: path{std::move(path)}, pending{}, stopping{false}, mutex{}, cv{}, worker{[this]() { run(); }} {}
+
+snapshot_writer::~snapshot_writer() {
+    {
+        std::lock_guard lock {mutex};
+        stopping = true;
+    }
+    cv.notify_one();
+    worker.join();
+}
+
+void snapshot_writer::submit(std::uint64_t version, std::vector<dpt::general> generals) {
+    {
+        std::lock_guard lock {mutex};
+        pending.emplace(version, std::move(generals));
+    }
+    cv.notify_one();
+}
+
+void snapshot_writer::run() {
+    while (true) {
+        std::unique_lock lock {mutex};
+        cv.wait(lock, [this]() { return pending || stopping; });
+        if (!pending) {
+            return;
+        }
+        auto [version, generals] = std::move(*pending);
+        pending.reset();
+        lock.unlock();
+
+        if (!snapshot::save(path, version, generals)) {
+            std::cerr << "Could not save snapshot to " << path << std::endl;
+        }
+    }
+}
+} // namespace dpt
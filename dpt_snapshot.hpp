@@ -0,0 +1,64 @@
+#pragma once
+
+#include "collect_dpt.hpp"
+#include <condition_variable>
+#include <cstdint>
+#include "dpt_thread_statistics.hpp"
+#include "mmap_toolbox.hpp"
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace dpt {
+/// the counters of every collected thread in a flat layout that is read in place from a mapped file:
+/// header, general records, thread records, thread lookup, counter records, string bytes.
+/// integers are fixed width in native byte order like the other binary files, every section is 8 byte aligned.
+/// a snapshot is only accepted if its size and checksum match, so a torn write is never read
+class snapshot {
+public:
+    /// false if the file is missing, of another format or corrupt
+    bool open(const std::string& path);
+    void close();
+    bool is_open() const;
+
+    /// matcher::version() of the definitions the counters were computed with
+    std::uint64_t version() const;
+    std::size_t size() const;
+
+    /// the threads of a general in the order they were collected, without post texts
+    std::vector<dpt::statistics> threads(std::string_view general_name, std::string_view board) const;
+    /// a thread that hasn't changed since the snapshot was written, last_modified has to be known
+    std::optional<dpt::statistics> find(std::string_view board, unsigned int id, std::int64_t last_modified) const;
+
+    static bool save(const std::string& path, std::uint64_t version, const std::vector<dpt::general>& generals);
+private:
+    dpt::statistics restore(std::size_t thread_index) const;
+
+    toolbox::mmap::mapped_file file;
+};
+
+/// saves snapshots on a background thread so collecting doesn't wait for the disk. if states are submitted
+/// faster than they are written only the most recent one is written, the destructor writes the pending state
+class snapshot_writer {
+public:
+    explicit snapshot_writer(std::string path);
+    snapshot_writer(const snapshot_writer&) = delete;
+    snapshot_writer& operator=(const snapshot_writer&) = delete;
+    ~snapshot_writer();
+
+    void submit(std::uint64_t version, std::vector<dpt::general> generals);
+private:
+    void run();
+
+    std::string path;
+    std::optional<std::pair<std::uint64_t, std::vector<dpt::general>>> pending;
+    bool stopping;
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::thread worker;
+};
+} // namespace dpt
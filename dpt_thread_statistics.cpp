@@ -1,37 +1,42 @@
+#include <array>
+#include <cstdint>
+#include "dpt_inverted_index.hpp"
 #include "dpt_thread_statistics.hpp"
 #include <sstream>
 #include <string>
 #include "string_toolbox.hpp"
 #include <string_view>
 #include <utility>
-#include <vector>
 
 namespace dpt {
-statistics::statistics(unsigned int id, std::string_view&& title, std::string_view&& timestamp)
-: id{id}, title{title}, timestamp{timestamp}, posts{},
+statistics::statistics(unsigned int id, std::string_view&& board, std::string_view&& title, std::string_view&& timestamp)
+: id{id}, board{board}, title{title}, timestamp{timestamp}, posts{}, last_modified{0},
   language_mentions{}, meme_posts{}, topic_discussions{}, insults{}, programming_jokes{}, buzzwords{},
-  n_code_snippets{0} {}
+  n_code_snippets{0}, n_ingested_posts{0}, index{},
+  on_ingest{}, sample_size{0}, sample_random{id}, threadlink_begin{"<a href=\"/" + std::string(board)} {}
 
-statistics::post::post(std::string_view&& text, bool quotes, bool quotes_op)
-: text{text}, quotes{quotes}, quotes_op{quotes_op} {}
+statistics::post::post(std::string_view&& text, bool quotes, bool quotes_op, std::uint64_t no)
+: text{text}, quotes{quotes}, quotes_op{quotes_op}, no{no} {}
 
-void statistics::add_post(std::string post) {
-    static const std::vector<std::pair<std::string, std::string>> to_erase = {
-        {"<a href=\"#p", "</a>"}, // quotelink
-        {"<a href=\"/g", "</a>"}  // threadlink
+void statistics::add_post(std::string post, std::uint64_t no) {
+    constexpr std::string_view end_segment = "</a>";
+    constexpr std::string_view op_end_segment = "(OP)</a>";
+    const std::array<std::string_view, 2> begin_segments = {
+        "<a href=\"#p",     // quotelink
+        threadlink_begin    // threadlink
     };
 
     bool quotes = false;
     bool quotes_op = false;
-    for (const auto& [begin_segment, end_segment] : to_erase) {
+    for (auto begin_segment : begin_segments) {
         std::size_t p = std::string::npos;
         while ((p = post.find(begin_segment)) != std::string::npos) {
             quotes = true;
-            if (post.find("(OP)" + end_segment, p) != std::string::npos) {
+            if (post.find(op_end_segment, p) != std::string::npos) {
                 quotes_op = true;
             }
             auto p_end = post.find(end_segment) + end_segment.size();
-            if (p_end != std::string::npos) {
+            if ((p_end != std::string::npos) && (p_end != p)) { // nothing to erase if an end segment ends right where the link begins
                 post.erase(p, p_end - p);
             } else {
                 break;
@@ -45,12 +50,49 @@ void statistics::add_post(std::string post) {
     post = toolbox::string::replace(std::move(post), "&quot;", "\"");
     post = toolbox::string::trim(std::move(post));
 
-    posts.emplace_back(post, quotes, quotes_op);
+    if (index) {
+        index->add(no, post);
+    }
+    ++n_ingested_posts;
+    if (!on_ingest) {
+        posts.emplace_back(post, quotes, quotes_op, no);
+        return;
+    }
+
+    statistics::post p {post, quotes, quotes_op, no};
+    on_ingest(*this, p);
+    if (posts.size() < sample_size) {
+        posts.push_back(std::move(p));
+    } else if (sample_size != 0) {
+        std::size_t i = std::uniform_int_distribution<std::size_t>{0, n_ingested_posts - 1}(sample_random);
+        if (i < sample_size) {
+            posts[i] = std::move(p);
+        }
+    }
+}
+
+void statistics::analyse_on_ingest(ingest_function on_ingest, std::size_t sample_size) {
+    this->on_ingest = std::move(on_ingest);
+    this->sample_size = sample_size;
+}
+
+bool statistics::analyses_on_ingest() const {
+    return static_cast<bool>(on_ingest);
+}
+
+void statistics::merge(const statistics& other) {
+    for (auto counter : statistics_counters) {
+        for (const auto& [key, mentions] : other.*counter) {
+            (this->*counter)[key] += mentions;
+        }
+    }
+    n_code_snippets += other.n_code_snippets;
+    n_ingested_posts += other.n_ingested_posts;
 }
 
 std::string statistics::thread_info_to_string() const {
     std::stringstream ss;
-    ss << timestamp << " - /g/thread/" << id << " - " << title;
+    ss << timestamp << " - /" << board << "/thread/" << id << " - " << title;
     return std::move(ss.str());
 }
 } // namespace dpt
@@ -1,6 +1,12 @@
 #pragma once
 
+#include <array>
+#include <cstdint>
+#include "dpt_inverted_index.hpp"
+#include <functional>
 #include <map>
+#include <memory>
+#include <random>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -9,18 +15,22 @@ namespace dpt {
 struct statistics {
     using mentions_counter = std::map<std::string, std::size_t>;
     struct post {
-        post(std::string_view&& text, bool quotes, bool quotes_op);
+        post(std::string_view&& text, bool quotes, bool quotes_op, std::uint64_t no);
         std::string text;
         bool quotes;
         bool quotes_op;
+        std::uint64_t no;
     };
+    using ingest_function = std::function<void(statistics&, const post&)>;
 
-    statistics(unsigned int id, std::string_view&& title, std::string_view&& timestamp);
+    statistics(unsigned int id, std::string_view&& board, std::string_view&& title, std::string_view&& timestamp);
 
     const unsigned int id;
+    const std::string board;
     const std::string title;
     const std::string timestamp;
-    std::vector<post> posts;
+    std::vector<post> posts; // a reservoir sample when analysing on ingest
+    std::int64_t last_modified; // catalog time of the last change, 0 if unknown
 
     mentions_counter language_mentions;
     mentions_counter meme_posts;
@@ -30,8 +40,31 @@ struct statistics {
     mentions_counter buzzwords;
 
     std::size_t n_code_snippets;
+    std::size_t n_ingested_posts;
+    std::shared_ptr<dpt::inverted_index> index; // every added post is indexed if set
 
-    void add_post(std::string post);
+    void add_post(std::string post, std::uint64_t no = 0);
+    /// every post added from now on is handed to on_ingest instead of being kept,
+    /// posts only keeps a uniform random sample of up to sample_size of them
+    void analyse_on_ingest(ingest_function on_ingest, std::size_t sample_size = 0);
+    bool analyses_on_ingest() const;
+    /// adds the counters of other, posts are not merged
+    void merge(const statistics& other);
     std::string thread_info_to_string() const;
+private:
+    ingest_function on_ingest;
+    std::size_t sample_size;
+    std::minstd_rand sample_random;
+    const std::string threadlink_begin; // built once, add_post runs for every post
+};
+
+/// every mentions counter of statistics, in declaration order
+inline constexpr std::array<statistics::mentions_counter statistics::*, 6> statistics_counters = {
+    &statistics::language_mentions,
+    &statistics::meme_posts,
+    &statistics::topic_discussions,
+    &statistics::insults,
+    &statistics::programming_jokes,
+    &statistics::buzzwords
 };
 } // namespace dpt
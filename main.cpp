@@ -1,16 +1,320 @@
+#include <algorithm>
 #include "analyse_dpt.hpp"
+#include "batch_dpt.hpp"
+#include "benchmark_dpt.hpp"
+#include <chrono>
+#include <cstdint>
 #include "collect_dpt.hpp"
+#include "dashboard_dpt.hpp"
+#include "dpt_definitions.hpp"
+#include "dpt_inverted_index.hpp"
+#include "dpt_post_memo.hpp"
+#include "dpt_snapshot.hpp"
 #include "dpt_thread_statistics.hpp"
+#include <iostream>
+#include <memory>
+#include <optional>
+#include "query_dpt.hpp"
+#include <regex>
 #include "report_dpt.hpp"
+#include <string>
+#include <string_view>
+#include <thread>
+#include "thread_toolbox.hpp"
+#include "verify_dpt.hpp"
+#include <vector>
 
-#include <iostream>
+namespace {
+enum class run_mode {collect, map, reduce, query, verify, benchmark_http};
+
+struct options {
+    run_mode mode{run_mode::collect};
+    std::optional<std::string> definitions_path{};
+    std::optional<std::chrono::seconds> daemon_interval{};
+    std::optional<std::string> memo_path{};
+    std::vector<dpt::target> targets{};
+    std::size_t n_workers{toolbox::thread::default_worker_count()};
+    std::size_t n_connections{8};
+    std::optional<std::size_t> stream_sample_size{};
+    std::optional<std::string> index_dir{};
+    std::optional<std::string> snapshot_path{};
+    std::optional<std::chrono::milliseconds> live_refresh_interval{};
+    std::string phrase{};
+    std::string cooccurring_phrase{};
+    std::size_t n_verify_posts{0};
+    std::uint64_t seed{1};
+    std::string host{};
+    std::uint16_t port{80};
+    std::size_t n_requests{0};
+    std::size_t shard{0};
+    std::size_t n_shards{1};
+    std::string output_path{};
+    std::vector<std::string> inputs{};
+};
+
+void usage(std::ostream& os) {
+    os << "usage: dptstat [--definitions <file.json>] [--daemon <seconds>] [--memo <file>] [--workers <n>] [--connections <n>] [--stream <sample size>]" << std::endl
+       << "               [--index <directory>] [--snapshot <file>] [--live <refresh ms>] [--general <board> <subject prefix>]... [--general-regex <board> <subject regex>]..." << std::endl
+       << "       dptstat [--definitions <file.json>] [--workers <n>] [--index <directory>] --map <shard>/<shards> <partial output> <thread files or directories>..." << std::endl
+       << "       dptstat --reduce <partial output or - to report> <partials>..." << std::endl
+       << "       dptstat [--cooccurring <phrase>] --query <phrase> <index files or directories>..." << std::endl
+       << "       dptstat [--definitions <file.json>] [--seed <n>] --verify <posts>" << std::endl
+       << "       dptstat [--connections <n>] --benchmark-http <host> <port> <requests>" << std::endl;
+}
+
+int run_map(const options& opts) {
+    auto m = dpt::current_matcher();
+    auto partial = dpt::map_shard(dpt::shard_files(opts.inputs, opts.shard, opts.n_shards), m, opts.n_workers, opts.index_dir);
+    if (!partial.save(opts.output_path)) {
+        std::cerr << "Could not save partial result to " << opts.output_path << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+int run_reduce(const options& opts) {
+    try {
+        auto partial = dpt::reduce(opts.inputs);
+        if (opts.output_path != "-") {
+            return partial.save(opts.output_path) ? 0 : 1;
+        }
+        for (const auto& [key, stats] : partial.threads) {
+            dpt::report(std::cout, stats);
+        }
+        dpt::report(std::cout, partial.total());
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
+
+int run_query(const options& opts) {
+    try {
+        dpt::query(std::cout, dpt::load_indexes(opts.inputs), opts.phrase, opts.cooccurring_phrase);
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
+
+/// reports the generals of the snapshot straight away, before anything is downloaded
+void report_snapshot(const options& opts, const dpt::snapshot& snap, dpt::dashboard* dash) {
+    if (!snap.is_open() || (snap.version() != dpt::current_matcher()->version())) {
+        return;
+    }
+    std::vector<dpt::general> generals;
+    for (const auto& t : opts.targets) {
+        generals.push_back({t, snap.threads(t.name, t.board)});
+    }
+    if (dash) {
+        dash->update(generals);
+        return;
+    }
+    for (const auto& gen : generals) {
+        if (!gen.threads.empty()) {
+            dpt::report(std::cout, gen);
+        }
+    }
+}
+
+int run_verify(const options& opts) {
+    try {
+        const auto defs = opts.definitions_path ? dpt::definitions::from_file(*opts.definitions_path) : dpt::definitions::builtin();
+        auto divergence = dpt::verify(defs, dpt::ingest_analyser(dpt::current_matcher()), opts.n_verify_posts, opts.seed);
+        if (divergence) {
+            dpt::report(std::cout, *divergence);
+            return 1;
+        }
+        std::cout << opts.n_verify_posts << " posts analysed identically (seed " << opts.seed << ")" << std::endl;
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
+
+int run_benchmark_http(const options& opts) {
+    return dpt::benchmark_http(std::cout, opts.host, opts.port, opts.n_requests, opts.n_connections) ? 0 : 1;
+}
 
-int main() {
-    auto thread_data = dpt::collect();
+void run_once(const options& opts, dpt::post_memo& memo, dpt::snapshot& resume, dpt::snapshot_writer* writer, dpt::dashboard* dash) {
+    auto m = dpt::current_matcher();
+    dpt::collect_options collect_opts{};
+    collect_opts.n_workers = opts.n_workers;
+    collect_opts.n_connections = opts.n_connections;
+    collect_opts.analyse_on_ingest = opts.stream_sample_size.has_value() || dash; // the dashboard shows counters while threads come in
+    collect_opts.sample_size = opts.stream_sample_size.value_or(0);
+    collect_opts.build_index = opts.index_dir.has_value();
+    collect_opts.resume = &resume;
+    if (dash) {
+        collect_opts.on_thread = [dash](const dpt::target& t, const dpt::statistics& stats) {
+            dash->update(t, stats);
+        };
+    }
+    auto generals = dpt::collect(opts.targets, m, opts.memo_path ? &memo : nullptr, collect_opts);
+    resume.close(); // only needed once after a restart, and windows can't replace a mapped file
 
-    for (auto& thread : thread_data) {
-        dpt::analyse(thread);
-        dpt::report(std::cout, thread);
+    for (auto& gen : generals) {
+        toolbox::thread::parallel_for(gen.threads.size(), opts.n_workers, [&](std::size_t i) {
+            dpt::analyse(gen.threads[i], *m, opts.memo_path ? &memo : nullptr);
+        });
+        if (!dash) {
+            dpt::report(std::cout, gen);
+        }
+        if (opts.index_dir) {
+            for (const auto& stats : gen.threads) {
+                if (!stats.index->save(dpt::index_path(*opts.index_dir, stats.board, stats.id))) {
+                    std::cerr << "Could not save the index of " << stats.thread_info_to_string() << std::endl;
+                }
+            }
+        }
+    }
+    if (opts.memo_path) {
+        memo.prune();
+        if (!memo.save(*opts.memo_path)) {
+            std::cerr << "Could not save memo to " << *opts.memo_path << std::endl;
+        }
+    }
+    if (dash) {
+        dash->update(generals);
+    }
+    if (writer) {
+        writer->submit(m->version(), std::move(generals));
+    }
+}
+} // namespace
+
+int main(int argc, char** argv) {
+    options opts{};
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string_view arg {argv[i]};
+            if ((arg == "--definitions") && (i + 1 < argc)) {
+                opts.definitions_path = argv[++i];
+            } else if ((arg == "--daemon") && (i + 1 < argc)) {
+                opts.daemon_interval = std::chrono::seconds{std::stoul(argv[++i])};
+            } else if ((arg == "--memo") && (i + 1 < argc)) {
+                opts.memo_path = argv[++i];
+            } else if ((arg == "--workers") && (i + 1 < argc)) {
+                opts.n_workers = std::max(1ul, std::stoul(argv[++i]));
+            } else if ((arg == "--connections") && (i + 1 < argc)) {
+                opts.n_connections = std::max(1ul, std::stoul(argv[++i]));
+            } else if ((arg == "--stream") && (i + 1 < argc)) {
+                opts.stream_sample_size = std::stoul(argv[++i]);
+            } else if ((arg == "--index") && (i + 1 < argc)) {
+                opts.index_dir = argv[++i];
+            } else if ((arg == "--snapshot") && (i + 1 < argc)) {
+                opts.snapshot_path = argv[++i];
+            } else if ((arg == "--cooccurring") && (i + 1 < argc)) {
+                opts.cooccurring_phrase = argv[++i];
+            } else if ((arg == "--query") && (i + 2 < argc)) {
+                opts.mode = run_mode::query;
+                opts.phrase = argv[++i];
+                opts.inputs.assign(argv + i + 1, argv + argc);
+                i = argc;
+            } else if ((arg == "--live") && (i + 1 < argc)) {
+                opts.live_refresh_interval = std::chrono::milliseconds{std::max(1ul, std::stoul(argv[++i]))};
+            } else if ((arg == "--seed") && (i + 1 < argc)) {
+                opts.seed = std::stoull(argv[++i]);
+            } else if ((arg == "--verify") && (i + 1 < argc)) {
+                opts.mode = run_mode::verify;
+                opts.n_verify_posts = std::stoul(argv[++i]);
+            } else if ((arg == "--benchmark-http") && (i + 3 < argc)) {
+                opts.mode = run_mode::benchmark_http;
+                opts.host = argv[++i];
+                opts.port = static_cast<std::uint16_t>(std::stoul(argv[++i]));
+                opts.n_requests = std::stoul(argv[++i]);
+            } else if ((arg == "--general") && (i + 2 < argc)) {
+                opts.targets.emplace_back(argv[i + 2], argv[i + 1], argv[i + 2]);
+                i += 2;
+            } else if ((arg == "--general-regex") && (i + 2 < argc)) {
+                opts.targets.emplace_back(argv[i + 2], argv[i + 1], std::regex{argv[i + 2]});
+                i += 2;
+            } else if (((arg == "--map") && (i + 3 < argc)) || ((arg == "--reduce") && (i + 2 < argc))) {
+                if (arg == "--map") {
+                    opts.mode = run_mode::map;
+                    std::string_view shard {argv[++i]};
+                    auto p = shard.find('/');
+                    opts.shard = std::stoul(std::string(shard.substr(0, p)));
+                    opts.n_shards = (p != std::string_view::npos) ? std::stoul(std::string(shard.substr(p + 1))) : 0;
+                    if ((opts.n_shards == 0) || (opts.shard >= opts.n_shards)) {
+                        usage(std::cerr);
+                        return 1;
+                    }
+                } else {
+                    opts.mode = run_mode::reduce;
+                }
+                opts.output_path = argv[++i];
+                opts.inputs.assign(argv + i + 1, argv + argc);
+                i = argc;
+            } else {
+                usage(std::cerr);
+                return 1;
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        usage(std::cerr);
+        return 1;
+    }
+
+    if (opts.targets.empty()) {
+        opts.targets.emplace_back("/dpt/", "g", "/dpt/");
+    }
+
+    if (opts.definitions_path) {
+        try {
+            dpt::install_matcher(std::make_shared<const dpt::matcher>(dpt::definitions::from_file(*opts.definitions_path)));
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+    }
+
+    if (opts.mode == run_mode::map) {
+        return run_map(opts);
+    } else if (opts.mode == run_mode::reduce) {
+        return run_reduce(opts);
+    } else if (opts.mode == run_mode::query) {
+        return run_query(opts);
+    } else if (opts.mode == run_mode::verify) {
+        return run_verify(opts);
+    } else if (opts.mode == run_mode::benchmark_http) {
+        return run_benchmark_http(opts);
+    }
+
+    std::optional<dpt::dashboard> dash{};
+    if (opts.live_refresh_interval) {
+        dash.emplace(std::cout, *opts.live_refresh_interval);
+    }
+
+    dpt::snapshot resume{};
+    std::optional<dpt::snapshot_writer> writer{};
+    if (opts.snapshot_path) {
+        resume.open(*opts.snapshot_path);
+        report_snapshot(opts, resume, dash ? &*dash : nullptr);
+        writer.emplace(*opts.snapshot_path);
+    }
+
+    dpt::post_memo memo{};
+    if (opts.memo_path) {
+        memo.load(*opts.memo_path);
+    }
+
+    if (!opts.daemon_interval) {
+        run_once(opts, memo, resume, writer ? &*writer : nullptr, dash ? &*dash : nullptr);
+        return 0;
+    }
+
+    std::optional<dpt::definitions_watcher> watcher{};
+    if (opts.definitions_path) {
+        watcher.emplace(*opts.definitions_path, std::chrono::seconds{1});
+    }
+    while (true) {
+        run_once(opts, memo, resume, writer ? &*writer : nullptr, dash ? &*dash : nullptr);
+        std::this_thread::sleep_for(*opts.daemon_interval);
     }
     return 0;
 }
@@ -0,0 +1,70 @@
+#include <algorithm>
+#include <cstdint>
+#include "dpt_inverted_index.hpp"
+#include <iomanip>
+#include <iterator>
+#include <ostream>
+#include "query_dpt.hpp"
+#include <string_view>
+#include <vector>
+
+namespace {
+std::size_t count_shared_posts(const std::vector<dpt::inverted_index::occurrence>& lhs, const std::vector<dpt::inverted_index::occurrence>& rhs) {
+    std::vector<std::uint64_t> lhs_posts, rhs_posts, shared_posts;
+    for (const auto& o : lhs) {
+        lhs_posts.push_back(o.post_no);
+    }
+    for (const auto& o : rhs) {
+        rhs_posts.push_back(o.post_no);
+    }
+    lhs_posts.erase(std::unique(lhs_posts.begin(), lhs_posts.end()), lhs_posts.end());
+    rhs_posts.erase(std::unique(rhs_posts.begin(), rhs_posts.end()), rhs_posts.end());
+    std::set_intersection(lhs_posts.begin(), lhs_posts.end(), rhs_posts.begin(), rhs_posts.end(), std::back_inserter(shared_posts));
+    return shared_posts.size();
+}
+} // namespace
+
+namespace dpt {
+void query(std::ostream& os, const std::vector<dpt::inverted_index>& indexes, std::string_view phrase, std::string_view cooccurring_phrase) {
+    os << "\"" << phrase << "\"";
+    if (!cooccurring_phrase.empty()) {
+        os << " in threads mentioning \"" << cooccurring_phrase << "\"";
+    }
+    os << std::endl << std::endl;
+
+    std::size_t n_occurrences = 0;
+    std::size_t n_posts = 0;
+    std::size_t n_shared_posts = 0;
+    std::size_t n_threads = 0;
+    for (const auto& index : indexes) {
+        auto occurrences = index.find(phrase);
+        if (occurrences.empty()) {
+            continue;
+        }
+        std::vector<dpt::inverted_index::occurrence> cooccurrences;
+        if (!cooccurring_phrase.empty()) {
+            cooccurrences = index.find(cooccurring_phrase);
+            if (cooccurrences.empty()) {
+                continue;
+            }
+        }
+        std::size_t thread_posts = inverted_index::count_posts(occurrences);
+        os << "  thread " << std::setw(10) << std::left << index.thread() << " : " << occurrences.size() << " time(s) in " << thread_posts << " post(s)";
+        if (!cooccurring_phrase.empty()) {
+            std::size_t shared_posts = count_shared_posts(occurrences, cooccurrences);
+            os << ", " << shared_posts << " post(s) mention both";
+            n_shared_posts += shared_posts;
+        }
+        n_occurrences += occurrences.size();
+        n_posts += thread_posts;
+        ++n_threads;
+        os << std::endl;
+    }
+    os << std::endl
+       << "Total: " << n_occurrences << " time(s) in " << n_posts << " post(s) across " << n_threads << " of " << indexes.size() << " thread(s)";
+    if (!cooccurring_phrase.empty()) {
+        os << ", " << n_shared_posts << " post(s) mention both";
+    }
+    os << std::endl;
+}
+} // namespace dpt
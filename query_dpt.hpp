@@ -0,0 +1,12 @@
+#pragma once
+
+#include "dpt_inverted_index.hpp"
+#include <ostream>
+#include <string_view>
+#include <vector>
+
+namespace dpt {
+/// reports how often a phrase (a single term or several consecutive terms) occurs per thread. if cooccurring_phrase
+/// isn't empty only threads in which it occurs as well are counted, along with the posts that contain both
+void query(std::ostream& os, const std::vector<dpt::inverted_index>& indexes, std::string_view phrase, std::string_view cooccurring_phrase = {});
+} // namespace dpt
@@ -34,13 +34,13 @@ struct horizontal_table_buffer {
     }
     void to_stream(std::ostream& os) const {
         for (const auto& line : lines) {
-            os << line << std::endl;
+            os << line << '\n';
         }
     }
 };
 
 void language_mentions_overview(std::ostream& os, const dpt::statistics& stats) {
-    os << "Languages discussed by post count" << std::endl;
+    os << "Languages discussed by post count" << '\n';
 
     const std::size_t index_width = 5;
     const std::size_t index_numbers = 4;
@@ -55,7 +55,7 @@ void language_mentions_overview(std::ostream& os, const dpt::statistics& stats)
     }
     const float scaling_factor = static_cast<float>(max_mentions) / static_cast<float>(column_height);
 
-    os << std::endl;
+    os << '\n';
     os << std::setw(index_width) << " ";
     for (const auto& [language, mentions] : stats.language_mentions) {
         if (mentions == max_mentions) {
@@ -64,7 +64,7 @@ void language_mentions_overview(std::ostream& os, const dpt::statistics& stats)
             os << std::left << std::setw(column_width) << " ";
         }
     }
-    os << std::endl;
+    os << '\n';
 
     for (std::size_t i = column_height; i > 0; --i) {
         const std::size_t min_mentions = static_cast<float>(i) * scaling_factor;
@@ -85,7 +85,7 @@ void language_mentions_overview(std::ostream& os, const dpt::statistics& stats)
                 os << std::left << std::setw(column_width) << " ";
             }
         }
-        os << std::endl;
+        os << '\n';
     }
 
     // what is this even im too dumb for this shit
@@ -108,9 +108,9 @@ void language_mentions_overview(std::ostream& os, const dpt::statistics& stats)
             }
             ++j;
         }
-        os << std::endl;
+        os << '\n';
     }
-    os << std::string((stats.language_mentions.size() * column_width + index_width), '-') << std::endl;
+    os << std::string((stats.language_mentions.size() * column_width + index_width), '-') << '\n';
 }
 void basic_table_overview(horizontal_table_buffer<>& buffer, const dpt::statistics::mentions_counter& table, std::string_view header, std::string_view count_label) {
     if (!table.empty()) {
@@ -133,13 +133,13 @@ void basic_table_overview(horizontal_table_buffer<>& buffer, const dpt::statisti
 
 namespace dpt {
 void report(std::ostream& os, const dpt::statistics& stats) {
-    os << "Thread statistics" << std::endl
-       << stats.thread_info_to_string() << std::endl
-       << std::endl;
+    os << "Thread statistics" << '\n'
+       << stats.thread_info_to_string() << '\n'
+       << '\n';
     language_mentions_overview(os, stats);
-    os << std::endl;
-    os << "Actual number of code snippets posted: " << stats.n_code_snippets << std::endl
-       << std::endl;
+    os << '\n';
+    os << "Actual number of code snippets posted: " << stats.n_code_snippets << '\n'
+       << '\n';
     {
         horizontal_table_buffer buffer{};
         basic_table_overview(buffer, stats.topic_discussions, "Topics discussed", "discussed");
@@ -147,15 +147,24 @@ void report(std::ostream& os, const dpt::statistics& stats) {
         basic_table_overview(buffer, stats.buzzwords, "Buzzwords", "counted");
         buffer.to_stream(os);
     }
-    os << std::endl;
+    os << '\n';
     {
         horizontal_table_buffer buffer{};
         basic_table_overview(buffer, stats.insults, "Groups insulted", "insulted");
         basic_table_overview(buffer, stats.programming_jokes, "Other statistics", "declared");
         buffer.to_stream(os);
     }
+    os << '\n';
+    os << std::string(50, '_') << '\n';
     os << std::endl;
-    os << std::string(50, '_') << std::endl;
-    os << std::endl;
+}
+
+void report(std::ostream& os, const dpt::general& gen) {
+    os << "General " << gen.target.name << " on /" << gen.target.board << "/ - " << gen.threads.size() << " thread(s)" << '\n'
+       << std::string(50, '=') << '\n'
+       << std::endl;
+    for (const auto& thread : gen.threads) {
+        report(os, thread);
+    }
 }
 } // namespace dpt
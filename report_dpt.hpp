@@ -1,8 +1,10 @@
 #pragma once
 
 #include "analyse_dpt.hpp"
+#include "collect_dpt.hpp"
 #include <ostream>
 
 namespace dpt {
 void report(std::ostream& os, const dpt::statistics& stats);
+void report(std::ostream& os, const dpt::general& gen);
 } // namespace dpt
@@ -0,0 +1,545 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include "string_toolbox.hpp"
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <sys/epoll.h>
+#endif
+
+namespace toolbox {
+namespace async_http {
+namespace internal {
+#ifdef _WIN32
+using socket_t = SOCKET;
+constexpr socket_t invalid_socket = INVALID_SOCKET;
+inline void close_socket(socket_t s) {
+    closesocket(s);
+}
+inline bool set_non_blocking(socket_t s) {
+    u_long mode = 1;
+    return ioctlsocket(s, FIONBIO, &mode) == 0;
+}
+inline bool connect_in_progress() {
+    return WSAGetLastError() == WSAEWOULDBLOCK;
+}
+inline bool would_block() {
+    return WSAGetLastError() == WSAEWOULDBLOCK;
+}
+using pollfd_t = WSAPOLLFD;
+inline int poll_sockets(pollfd_t* fds, std::size_t n, int timeout_ms) {
+    return WSAPoll(fds, static_cast<ULONG>(n), timeout_ms);
+}
+struct socket_library {
+    socket_library() {
+        WSADATA data;
+        WSAStartup(MAKEWORD(2, 2), &data);
+    }
+    ~socket_library() {
+        WSACleanup();
+    }
+};
+#else
+using socket_t = int;
+constexpr socket_t invalid_socket = -1;
+inline void close_socket(socket_t s) {
+    ::close(s);
+}
+inline bool set_non_blocking(socket_t s) {
+    int flags = fcntl(s, F_GETFL, 0);
+    return (flags != -1) && (fcntl(s, F_SETFL, flags | O_NONBLOCK) != -1);
+}
+inline bool connect_in_progress() {
+    return errno == EINPROGRESS;
+}
+inline bool would_block() {
+    return (errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR);
+}
+using pollfd_t = pollfd;
+inline int poll_sockets(pollfd_t* fds, std::size_t n, int timeout_ms) {
+    return ::poll(fds, static_cast<nfds_t>(n), timeout_ms);
+}
+struct socket_library {};
+#endif
+#ifdef MSG_NOSIGNAL
+constexpr int send_flags = MSG_NOSIGNAL;
+#else
+constexpr int send_flags = 0;
+#endif
+
+class io_handler {
+public:
+    virtual ~io_handler() = default;
+    virtual void on_io(bool readable, bool writable, bool failed) = 0;
+    virtual void on_tick(std::chrono::steady_clock::time_point now) = 0;
+};
+} // namespace internal
+
+/// single threaded readiness loop, epoll on linux and poll/WSAPoll everywhere else.
+/// every callback runs on the thread that calls run()
+class event_loop {
+public:
+    event_loop() : library{}, handlers{} {
+#ifdef __linux__
+        epoll_fd = epoll_create1(0);
+#endif
+    }
+    ~event_loop() {
+#ifdef __linux__
+        ::close(epoll_fd);
+#endif
+    }
+    /// runs until no socket is watched anymore
+    void run() {
+        constexpr int tick_ms = 100;
+        while (!handlers.empty()) {
+            std::vector<std::pair<internal::socket_t, short>> ready;
+#ifdef __linux__
+            std::array<epoll_event, 64> events;
+            int n = epoll_wait(epoll_fd, events.data(), static_cast<int>(events.size()), tick_ms);
+            for (int i = 0; i < n; ++i) {
+                internal::socket_t s = events[i].data.fd;
+                ready.emplace_back(s, static_cast<short>(
+                    ((events[i].events & EPOLLIN) ? POLLIN : 0) | ((events[i].events & EPOLLOUT) ? POLLOUT : 0) | ((events[i].events & (EPOLLERR | EPOLLHUP)) ? POLLERR : 0)));
+            }
+#else
+            std::vector<internal::pollfd_t> fds;
+            for (const auto& [s, watch] : handlers) {
+                internal::pollfd_t fd{};
+                fd.fd = s;
+                fd.events = static_cast<short>((watch.read ? POLLIN : 0) | (watch.write ? POLLOUT : 0));
+                fds.push_back(fd);
+            }
+            if (internal::poll_sockets(fds.data(), fds.size(), tick_ms) > 0) {
+                for (const auto& fd : fds) {
+                    if (fd.revents) {
+                        ready.emplace_back(fd.fd, static_cast<short>(fd.revents & (POLLIN | POLLOUT | POLLERR | POLLHUP)));
+                    }
+                }
+            }
+#endif
+            for (const auto& [s, revents] : ready) {
+                auto it = handlers.find(s); // a previous callback may have stopped watching this socket
+                if (it != handlers.end()) {
+                    it->second.handler->on_io(revents & POLLIN, revents & POLLOUT, revents & (POLLERR | POLLHUP));
+                }
+            }
+            auto now = std::chrono::steady_clock::now();
+            std::vector<internal::io_handler*> tick_handlers;
+            for (const auto& [s, watch] : handlers) {
+                if (std::find(tick_handlers.begin(), tick_handlers.end(), watch.handler) == tick_handlers.end()) {
+                    tick_handlers.push_back(watch.handler);
+                }
+            }
+            for (auto* handler : tick_handlers) {
+                if (is_watched(handler)) {
+                    handler->on_tick(now);
+                }
+            }
+        }
+    }
+
+    void watch(internal::socket_t s, internal::io_handler* handler, bool read, bool write) {
+        auto [it, inserted] = handlers.insert_or_assign(s, watch_t{handler, read, write});
+#ifdef __linux__
+        epoll_event event{};
+        event.events = (read ? static_cast<std::uint32_t>(EPOLLIN) : 0u) | (write ? static_cast<std::uint32_t>(EPOLLOUT) : 0u);
+        event.data.fd = s;
+        epoll_ctl(epoll_fd, inserted ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, s, &event);
+#endif
+    }
+    void unwatch(internal::socket_t s) {
+        if (handlers.erase(s)) {
+#ifdef __linux__
+            epoll_ctl(epoll_fd, EPOLL_CTL_DEL, s, nullptr);
+#endif
+        }
+    }
+private:
+    event_loop(const event_loop&) = delete;
+    event_loop& operator=(const event_loop&) = delete;
+
+    struct watch_t {
+        internal::io_handler* handler;
+        bool read;
+        bool write;
+    };
+    bool is_watched(internal::io_handler* handler) const {
+        return std::any_of(handlers.begin(), handlers.end(), [handler](const auto& watch){ return watch.second.handler == handler; });
+    }
+
+    internal::socket_library library;
+    std::map<internal::socket_t, watch_t> handlers;
+#ifdef __linux__
+    int epoll_fd;
+#endif
+};
+
+struct response {
+    int status{0}; // 0 if the request failed before a response was received
+    std::string body{};
+    std::string error{};
+
+    bool ok() const {
+        return (status >= 200) && (status < 300);
+    }
+};
+using completion_handler = std::function<void(response&&)>;
+
+/// plain HTTP/1.1 client for a single host, requests are spread over up to max_connections keep-alive connections
+/// and queued beyond that. the session and its loop have to outlive every request
+class session {
+public:
+    session(event_loop& loop, std::string_view host, std::uint16_t port = 80, std::size_t max_connections = 8, std::chrono::seconds timeout = std::chrono::seconds{30})
+    : loop{loop}, host{host}, address{}, address_length{0}, resolve_error{}, timeout{timeout}, queue{}, connections{} {
+        addrinfo hints{};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo* result = nullptr;
+        if (getaddrinfo(this->host.c_str(), std::to_string(port).c_str(), &hints, &result) == 0 && result) {
+            std::memcpy(&address, result->ai_addr, result->ai_addrlen);
+            address_length = static_cast<socklen_t>(result->ai_addrlen);
+            freeaddrinfo(result);
+        } else {
+            resolve_error = "could not resolve " + this->host;
+        }
+        for (std::size_t i = 0; i < std::max<std::size_t>(1, max_connections); ++i) {
+            connections.push_back(std::make_unique<connection>(*this));
+        }
+    }
+    void get(std::string_view object, completion_handler handler) {
+        std::string path {object};
+        if (path.empty() || path.front() != '/') {
+            path.insert(path.begin(), '/');
+        }
+        queue.push_back({std::move(path), std::move(handler)});
+        dispatch();
+    }
+    std::size_t pending() const {
+        return queue.size() + std::count_if(connections.begin(), connections.end(), [](const auto& c){ return c->busy(); });
+    }
+private:
+    session(const session&) = delete;
+    session& operator=(const session&) = delete;
+
+    struct pending_request {
+        std::string path;
+        completion_handler handler;
+    };
+
+    class connection : public internal::io_handler {
+    public:
+        explicit connection(session& owner) : owner{owner} {}
+        ~connection() override {
+            close();
+        }
+        bool busy() const {
+            return static_cast<bool>(current);
+        }
+        void start(pending_request&& req) {
+            current = std::make_unique<pending_request>(std::move(req));
+            retried = false;
+            send_request();
+        }
+        void on_io(bool readable, bool writable, bool failed) override {
+            try {
+                handle_io(readable, writable, failed);
+            } catch (const std::exception&) {
+                keep_alive = false;
+                fail("malformed response");
+            }
+        }
+        void on_tick(std::chrono::steady_clock::time_point now) override {
+            if (current && now > deadline) {
+                fail("request timed out");
+            }
+        }
+    private:
+        enum class state_t {closed, connecting, writing, reading, idle};
+
+        void handle_io(bool readable, bool writable, bool failed) {
+            if (state == state_t::connecting && (writable || failed)) {
+                int error = 0;
+                socklen_t length = sizeof(error);
+                getsockopt(s, SOL_SOCKET, SO_ERROR, reinterpret_cast<char*>(&error), &length);
+                if (error != 0 || failed) {
+                    return fail("could not connect to " + owner.host);
+                }
+                state = state_t::writing;
+            }
+            if (state == state_t::writing && writable) {
+                write();
+            }
+            if (state == state_t::reading && (readable || failed)) {
+                read();
+            }
+        }
+
+        void send_request() {
+            deadline = std::chrono::steady_clock::now() + owner.timeout;
+            out = "GET " + current->path + " HTTP/1.1\r\nHost: " + owner.host + "\r\nUser-Agent: dptstat\r\nConnection: keep-alive\r\n\r\n";
+            out_pos = 0;
+            in.clear();
+            header_end = std::string::npos;
+            reused = (state == state_t::idle);
+            if (state == state_t::idle) {
+                state = state_t::writing;
+                owner.loop.watch(s, this, false, true);
+                return;
+            }
+            if (!owner.resolve_error.empty()) {
+                return fail(owner.resolve_error);
+            }
+            s = socket(reinterpret_cast<const sockaddr*>(&owner.address)->sa_family, SOCK_STREAM, 0);
+            if (s == internal::invalid_socket || !internal::set_non_blocking(s)) {
+                return fail("could not create socket");
+            }
+            if (connect(s, reinterpret_cast<const sockaddr*>(&owner.address), owner.address_length) == 0) {
+                state = state_t::writing;
+            } else if (internal::connect_in_progress()) {
+                state = state_t::connecting;
+            } else {
+                return fail("could not connect to " + owner.host);
+            }
+            owner.loop.watch(s, this, false, true);
+        }
+        void write() {
+            while (out_pos < out.size()) {
+                auto n = send(s, out.data() + out_pos, static_cast<int>(out.size() - out_pos), internal::send_flags);
+                if (n < 0) {
+                    return internal::would_block() ? void() : retry_or_fail("could not send request");
+                }
+                out_pos += static_cast<std::size_t>(n);
+            }
+            state = state_t::reading;
+            owner.loop.watch(s, this, true, false);
+        }
+        void read() {
+            char buffer[16384];
+            while (true) {
+                auto n = recv(s, buffer, sizeof(buffer), 0);
+                if (n > 0) {
+                    in.append(buffer, static_cast<std::size_t>(n));
+                    if (parse(false)) {
+                        return;
+                    }
+                } else if (n == 0) {
+                    if (!parse(true)) {
+                        retry_or_fail("connection closed before the response was complete");
+                    }
+                    return;
+                } else {
+                    if (!internal::would_block()) {
+                        retry_or_fail("could not read response");
+                    }
+                    return;
+                }
+            }
+        }
+        /// returns true once the response is complete and has been handed to the completion handler
+        bool parse(bool eof) {
+            if (header_end == std::string::npos) {
+                header_end = in.find("\r\n\r\n");
+                if (header_end == std::string::npos) {
+                    return false;
+                }
+                header_end += 4;
+                response_status = 0;
+                content_length = std::string::npos;
+                chunked = false;
+                keep_alive = true;
+                body.clear();
+                body_pos = header_end;
+                parse_headers(std::string_view{in}.substr(0, header_end));
+            }
+            bool complete = false;
+            if (chunked) {
+                complete = parse_chunks();
+            } else if (content_length != std::string::npos) {
+                complete = (in.size() - header_end) >= content_length;
+                if (complete) {
+                    body = in.substr(header_end, content_length);
+                }
+            } else if (eof) {
+                body = in.substr(header_end);
+                keep_alive = false;
+                complete = true;
+            }
+            if (complete) {
+                finish();
+            }
+            return complete;
+        }
+        void parse_headers(std::string_view headers) {
+            auto line_end = headers.find("\r\n");
+            auto status_line = headers.substr(0, line_end);
+            auto p = status_line.find(' ');
+            if (p != std::string_view::npos) {
+                response_status = std::atoi(std::string(status_line.substr(p + 1, 3)).c_str());
+            }
+            if (toolbox::string::starts_with(status_line, "HTTP/1.0")) {
+                keep_alive = false;
+            }
+            while (line_end != std::string_view::npos && line_end + 2 < headers.size()) {
+                auto next = headers.find("\r\n", line_end + 2);
+                auto line = headers.substr(line_end + 2, next - (line_end + 2));
+                line_end = next;
+                auto colon = line.find(':');
+                if (colon == std::string_view::npos) {
+                    continue;
+                }
+                std::string name {line.substr(0, colon)};
+                std::string value {line.substr(colon + 1)};
+                std::transform(name.begin(), name.end(), name.begin(), [](char c){ return std::tolower(c); });
+                std::transform(value.begin(), value.end(), value.begin(), [](char c){ return std::tolower(c); });
+                value.erase(0, value.find_first_not_of(' '));
+                if (name == "content-length") {
+                    content_length = std::stoull(value);
+                } else if (name == "transfer-encoding" && value.find("chunked") != std::string::npos) {
+                    chunked = true;
+                } else if (name == "connection" && value.find("close") != std::string::npos) {
+                    keep_alive = false;
+                }
+            }
+        }
+        bool parse_chunks() {
+            while (true) {
+                auto line_end = in.find("\r\n", body_pos);
+                if (line_end == std::string::npos) {
+                    return false;
+                }
+                std::size_t chunk_size = std::stoull(in.substr(body_pos, line_end - body_pos), nullptr, 16);
+                if (chunk_size == 0) {
+                    auto trailer_end = in.find("\r\n", line_end + 2);
+                    if (trailer_end == std::string::npos) {
+                        return false;
+                    }
+                    // skip trailer headers, the response ends at the first empty line
+                    while (trailer_end != line_end + 2) {
+                        line_end = trailer_end;
+                        trailer_end = in.find("\r\n", line_end + 2);
+                        if (trailer_end == std::string::npos) {
+                            return false;
+                        }
+                    }
+                    return true;
+                }
+                if (in.size() < line_end + 2 + chunk_size + 2) {
+                    return false;
+                }
+                body.append(in, line_end + 2, chunk_size);
+                body_pos = line_end + 2 + chunk_size + 2;
+            }
+        }
+        void finish() {
+            response res {response_status, std::move(body), {}};
+            auto req = std::move(current);
+            if (keep_alive) {
+                state = state_t::idle;
+                owner.loop.unwatch(s);
+            } else {
+                close();
+            }
+            req->handler(std::move(res));
+            owner.dispatch();
+        }
+        /// a kept-alive connection may have been closed by the server in the meantime, that deserves one retry
+        void retry_or_fail(const std::string& error) {
+            if (reused && !retried && in.empty()) {
+                retried = true;
+                close();
+                return send_request();
+            }
+            fail(error);
+        }
+        void fail(const std::string& error) {
+            close();
+            if (current) {
+                auto req = std::move(current);
+                req->handler(response{0, {}, error});
+            }
+            owner.dispatch();
+        }
+        void close() {
+            if (s != internal::invalid_socket) {
+                owner.loop.unwatch(s);
+                internal::close_socket(s);
+                s = internal::invalid_socket;
+            }
+            state = state_t::closed;
+        }
+        session& owner;
+        internal::socket_t s{internal::invalid_socket};
+        state_t state{state_t::closed};
+        std::unique_ptr<pending_request> current{};
+        std::chrono::steady_clock::time_point deadline{};
+        bool reused{false};
+        bool retried{false};
+        std::string out{};
+        std::size_t out_pos{0};
+        std::string in{};
+        std::size_t header_end{std::string::npos};
+        std::size_t body_pos{0};
+        int response_status{0};
+        std::size_t content_length{std::string::npos};
+        bool chunked{false};
+        bool keep_alive{true};
+        std::string body{};
+    };
+
+    void dispatch() {
+        for (auto& c : connections) {
+            if (queue.empty()) {
+                return;
+            }
+            if (!c->busy()) {
+                auto req = std::move(queue.front());
+                queue.pop_front();
+                c->start(std::move(req));
+            }
+        }
+    }
+
+    event_loop& loop;
+    const std::string host;
+    sockaddr_storage address;
+    socklen_t address_length;
+    std::string resolve_error;
+    const std::chrono::seconds timeout;
+    std::deque<pending_request> queue;
+    std::vector<std::unique_ptr<connection>> connections;
+};
+} // namespace async_http
+} // namespace toolbox
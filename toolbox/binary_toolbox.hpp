@@ -0,0 +1,89 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+
+namespace toolbox {
+namespace binary {
+/// values are written in native byte order, files are only meant to be read back on the same architecture
+template <typename T> std::enable_if_t<std::is_trivially_copyable_v<T>>
+write(std::ostream& os, const T& value) {
+    os.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+inline void
+write(std::ostream& os, std::string_view str) {
+    write(os, static_cast<std::uint32_t>(str.size()));
+    os.write(str.data(), str.size());
+}
+template <typename T> std::enable_if_t<std::is_trivially_copyable_v<T>, bool>
+read(std::istream& is, T& value) {
+    return static_cast<bool>(is.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+inline bool
+read(std::istream& is, std::string& str) {
+    std::uint32_t size{0};
+    if (!read(is, size)) {
+        return false;
+    }
+    // grown chunk by chunk so a corrupt size can't allocate more than the stream holds
+    constexpr std::size_t chunk_size = 1 << 16;
+    str.clear();
+    while (str.size() < size) {
+        const std::size_t offset = str.size();
+        str.resize(offset + std::min<std::size_t>(chunk_size, size - offset));
+        if (!is.read(str.data() + offset, static_cast<std::streamsize>(str.size() - offset))) {
+            return false;
+        }
+    }
+    return true;
+}
+/// write_contents(std::ostream&) writes to path + ".tmp", which is then renamed to path, so a reader never sees a
+/// half written file. returns false if writing or renaming failed
+template <typename WriteFunction> bool
+write_file_atomically(const std::string& path, WriteFunction&& write_contents) {
+    const std::string tmp_path = path + ".tmp";
+    {
+        std::ofstream file {tmp_path, std::ios::binary | std::ios::trunc};
+        write_contents(static_cast<std::ostream&>(file));
+        if (!file.flush()) {
+            return false;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmp_path, path, ec);
+    return !ec;
+}
+/// LEB128, small numbers take a single byte
+inline void
+append_varint(std::vector<std::uint8_t>& buffer, std::uint64_t value) {
+    while (value >= 0x80) {
+        buffer.push_back(static_cast<std::uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    buffer.push_back(static_cast<std::uint8_t>(value));
+}
+/// advances it past the varint, returns false if the buffer ends before the varint does
+inline bool
+read_varint(const std::uint8_t*& it, const std::uint8_t* end, std::uint64_t& value) {
+    value = 0;
+    for (int shift = 0; (it != end) && (shift < 64); shift += 7) {
+        std::uint8_t byte = *it++;
+        value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+} // namespace binary
+} // namespace toolbox
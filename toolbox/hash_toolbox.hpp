@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+namespace toolbox {
+namespace hash {
+constexpr std::uint64_t fnv1a_offset_basis = 14695981039346656037ull;
+constexpr std::uint64_t fnv1a_prime = 1099511628211ull;
+
+/// FNV-1a, stable across platforms and runs so the result can be persisted
+constexpr std::uint64_t
+fnv1a(std::string_view str, std::uint64_t hash = fnv1a_offset_basis) noexcept {
+    for (char c : str) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= fnv1a_prime;
+    }
+    return hash;
+}
+} // namespace hash
+} // namespace toolbox
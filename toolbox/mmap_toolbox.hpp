@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace toolbox {
+namespace mmap {
+/// a whole file mapped read only, unmapped again on destruction
+class mapped_file {
+public:
+    mapped_file() = default;
+    mapped_file(const mapped_file&) = delete;
+    mapped_file& operator=(const mapped_file&) = delete;
+    mapped_file(mapped_file&& other) noexcept {
+        *this = std::move(other);
+    }
+    mapped_file& operator=(mapped_file&& other) noexcept {
+        if (this != &other) {
+            close();
+            std::swap(address, other.address);
+            std::swap(length, other.length);
+        }
+        return *this;
+    }
+    ~mapped_file() {
+        close();
+    }
+
+    /// false if the file doesn't exist, is empty or can't be mapped
+    bool open(const std::string& path) {
+        close();
+#ifdef _WIN32
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+        LARGE_INTEGER file_size;
+        HANDLE mapping = nullptr;
+        if (GetFileSizeEx(file, &file_size) && (file_size.QuadPart > 0)) {
+            mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        }
+        CloseHandle(file);
+        if (mapping == nullptr) {
+            return false;
+        }
+        address = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        CloseHandle(mapping);
+        if (address == nullptr) {
+            return false;
+        }
+        length = static_cast<std::size_t>(file_size.QuadPart);
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat st;
+        void* mapping = MAP_FAILED;
+        if ((fstat(fd, &st) == 0) && (st.st_size > 0)) {
+            mapping = ::mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        ::close(fd);
+        if (mapping == MAP_FAILED) {
+            return false;
+        }
+        address = mapping;
+        length = static_cast<std::size_t>(st.st_size);
+#endif
+        return true;
+    }
+    void close() {
+        if (address == nullptr) {
+            return;
+        }
+#ifdef _WIN32
+        UnmapViewOfFile(address);
+#else
+        ::munmap(address, length);
+#endif
+        address = nullptr;
+        length = 0;
+    }
+
+    const unsigned char* data() const {
+        return static_cast<const unsigned char*>(address);
+    }
+    std::size_t size() const {
+        return length;
+    }
+    bool is_open() const {
+        return address != nullptr;
+    }
+private:
+    void* address{nullptr};
+    std::size_t length{0};
+};
+} // namespace mmap
+} // namespace toolbox
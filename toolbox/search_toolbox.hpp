@@ -0,0 +1,115 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace toolbox {
+namespace search {
+/// Aho-Corasick automaton, counts every (overlapping) occurrence of every pattern in a single pass over the text.
+/// The counts are identical to calling toolbox::string::count once per pattern.
+class pattern_set {
+public:
+    using pattern_id = std::size_t;
+
+    pattern_set() : nodes(1), n_patterns{0}, compiled{false} {}
+
+    /// identical patterns share an id
+    pattern_id add(std::string_view pattern) {
+        std::size_t state = 0;
+        for (char c : pattern) {
+            std::size_t next = find_edge(state, c);
+            if (next == npos) {
+                next = nodes.size();
+                nodes[state].edges.emplace_back(c, next);
+                nodes.emplace_back();
+            }
+            state = next;
+        }
+        if (nodes[state].output == npos) {
+            nodes[state].output = n_patterns++;
+        }
+        compiled = false;
+        return nodes[state].output;
+    }
+    void compile() {
+        std::deque<std::size_t> queue;
+        for (auto& [c, child] : nodes[0].edges) {
+            nodes[child].fail = 0;
+            queue.push_back(child);
+        }
+        while (!queue.empty()) {
+            std::size_t state = queue.front();
+            queue.pop_front();
+            for (auto& [c, child] : nodes[state].edges) {
+                std::size_t fallback = nodes[state].fail;
+                while (fallback != 0 && find_edge(fallback, c) == npos) {
+                    fallback = nodes[fallback].fail;
+                }
+                std::size_t target = find_edge(fallback, c);
+                nodes[child].fail = (target != npos && target != child) ? target : 0;
+                std::size_t fail = nodes[child].fail;
+                nodes[child].dictionary = (nodes[fail].output != npos) ? fail : nodes[fail].dictionary;
+                queue.push_back(child);
+            }
+        }
+        for (auto& node : nodes) {
+            std::sort(node.edges.begin(), node.edges.end());
+        }
+        compiled = true;
+    }
+    /// adds the number of occurrences of each pattern to counts[id], counts is resized to size()
+    void count(std::string_view text, std::vector<std::size_t>& counts) const {
+        counts.assign(n_patterns, 0);
+        std::size_t state = 0;
+        for (char c : text) {
+            std::size_t next;
+            while ((next = find_edge(state, c)) == npos && state != 0) {
+                state = nodes[state].fail;
+            }
+            state = (next == npos) ? 0 : next;
+            for (std::size_t out = state; out != npos && out != 0; out = nodes[out].dictionary) {
+                if (nodes[out].output != npos) {
+                    ++counts[nodes[out].output];
+                }
+            }
+        }
+    }
+    std::size_t size() const {
+        return n_patterns;
+    }
+    bool is_compiled() const {
+        return compiled;
+    }
+private:
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+    struct node {
+        std::vector<std::pair<char, std::size_t>> edges{};
+        std::size_t fail{0};
+        std::size_t output{npos};
+        std::size_t dictionary{npos};
+    };
+
+    std::size_t find_edge(std::size_t state, char c) const {
+        const auto& edges = nodes[state].edges;
+        if (compiled) {
+            auto it = std::lower_bound(edges.begin(), edges.end(), c, [](const auto& edge, char value){ return edge.first < value; });
+            return (it != edges.end() && it->first == c) ? it->second : npos;
+        }
+        for (const auto& [edge_c, child] : edges) {
+            if (edge_c == c) {
+                return child;
+            }
+        }
+        return npos;
+    }
+
+    std::vector<node> nodes;
+    std::size_t n_patterns;
+    bool compiled;
+};
+} // namespace search
+} // namespace toolbox
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <sys/ioctl.h>
+#include <unistd.h>
+#endif
+
+namespace toolbox {
+namespace terminal {
+/// windows consoles only interpret ANSI escape sequences once asked to
+inline bool enable_escape_sequences() {
+#ifdef _WIN32
+    HANDLE console = GetStdHandle(STD_OUTPUT_HANDLE);
+    DWORD mode = 0;
+    return GetConsoleMode(console, &mode) && SetConsoleMode(console, mode | ENABLE_VIRTUAL_TERMINAL_PROCESSING);
+#else
+    return true;
+#endif
+}
+
+/// the height of the terminal stdout is shown in, 24 if stdout isn't a terminal
+inline std::size_t rows() {
+    constexpr std::size_t fallback = 24;
+#ifdef _WIN32
+    CONSOLE_SCREEN_BUFFER_INFO info;
+    if (GetConsoleScreenBufferInfo(GetStdHandle(STD_OUTPUT_HANDLE), &info) && (info.srWindow.Bottom >= info.srWindow.Top)) {
+        return static_cast<std::size_t>(info.srWindow.Bottom - info.srWindow.Top) + 1;
+    }
+#else
+    winsize size{};
+    if ((ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) == 0) && (size.ws_row != 0)) {
+        return size.ws_row;
+    }
+#endif
+    return fallback;
+}
+
+/// keeps the frame that is on the terminal and turns the next frame into the ANSI cursor moves and characters
+/// that differ from it. unchanged gaps shorter than a cursor move are rewritten instead of being skipped.
+/// cursor moves are absolute, so a frame is cut to the terminal height and redrawn from scratch when that changes
+class screen {
+public:
+    static constexpr std::size_t max_gap = 8;
+
+    /// the escape sequences that turn the previous frame into lines on a terminal of n_rows rows,
+    /// the first frame clears the terminal
+    std::string update(std::vector<std::string> lines, std::size_t n_rows) {
+        n_rows = std::max<std::size_t>(n_rows, 2);
+        if (lines.size() >= n_rows) {
+            // the last row holds the cursor, writing it would scroll the frame
+            const std::size_t n_hidden = lines.size() - (n_rows - 2);
+            lines.resize(n_rows - 2);
+            lines.push_back("... " + std::to_string(n_hidden) + " more line(s)");
+        }
+        if (n_rows != previous_rows) {
+            drawn = false;
+            previous_rows = n_rows;
+        }
+
+        std::string out;
+        if (!drawn) {
+            out += "\x1b[?25l\x1b[?7l\x1b[2J"; // hide the cursor, don't wrap, clear
+        }
+        const std::string empty{};
+        const std::size_t n_lines = std::max(lines.size(), previous.size());
+        for (std::size_t row = 0; row < n_lines; ++row) {
+            const std::string& now = (row < lines.size()) ? lines[row] : empty;
+            const std::string& before = (drawn && (row < previous.size())) ? previous[row] : empty;
+            auto differs = [&](std::size_t col) {
+                return (col >= before.size()) || (before[col] != now[col]);
+            };
+
+            std::size_t col = 0;
+            while (true) {
+                while ((col < now.size()) && !differs(col)) {
+                    ++col;
+                }
+                if (col >= now.size()) {
+                    break;
+                }
+                std::size_t last_difference = col;
+                for (std::size_t end = col; (end < now.size()) && ((end - last_difference) <= max_gap); ++end) {
+                    if (differs(end)) {
+                        last_difference = end;
+                    }
+                }
+                move_to(out, row, col);
+                out.append(now, col, last_difference + 1 - col);
+                col = last_difference + 1;
+            }
+            if (before.size() > now.size()) {
+                move_to(out, row, now.size());
+                out += "\x1b[K";
+            }
+        }
+        if (!out.empty()) {
+            move_to(out, lines.size(), 0);
+        }
+        previous = std::move(lines);
+        drawn = true;
+        return out;
+    }
+    /// writes the update in one go
+    void draw(std::ostream& os, std::vector<std::string> lines, std::size_t n_rows) {
+        const std::string out = update(std::move(lines), n_rows);
+        if (!out.empty()) {
+            os.write(out.data(), static_cast<std::streamsize>(out.size()));
+            os.flush();
+        }
+    }
+    /// shows the cursor and wraps lines again, the frame stays on the terminal
+    void release(std::ostream& os) {
+        if (drawn) {
+            os << "\x1b[?7h\x1b[?25h" << std::flush;
+        }
+        previous.clear();
+        previous_rows = 0;
+        drawn = false;
+    }
+private:
+    static void move_to(std::string& out, std::size_t row, std::size_t col) {
+        out += "\x1b[" + std::to_string(row + 1) + ";" + std::to_string(col + 1) + "H";
+    }
+
+    std::vector<std::string> previous{};
+    std::size_t previous_rows{0};
+    bool drawn{false};
+};
+} // namespace terminal
+} // namespace toolbox
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace toolbox {
+namespace thread {
+inline std::size_t default_worker_count() {
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+/// calls fn(i) for every i in [0, n) on up to n_workers threads (the calling thread included), indices are handed out in order
+template <typename Function> void
+parallel_for(std::size_t n, std::size_t n_workers, Function&& fn) {
+    std::atomic<std::size_t> next{0};
+    auto work = [&]() {
+        for (std::size_t i = next++; i < n; i = next++) {
+            fn(i);
+        }
+    };
+    n_workers = std::max<std::size_t>(1, std::min(n_workers, n));
+    std::vector<std::thread> workers;
+    for (std::size_t i = 1; i < n_workers; ++i) {
+        workers.emplace_back(work);
+    }
+    work();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+} // namespace thread
+} // namespace toolbox
@@ -0,0 +1,63 @@
+#!/usr/bin/env python3
+"""Local stand-in for a.4cdn.org to benchmark the HTTP client: `dptstat --benchmark-http 127.0.0.1 <port> <requests>`.
+
+Every request is answered after 200-500 ms. /<n>.json returns 4000-ish bytes, sent with a content-length, chunked
+or close-delimited depending on n % 3, so all three body framings and reconnects are exercised.
+"""
+import random
+import socket
+import sys
+import threading
+import time
+
+
+def response(n):
+    body = (('x%d-' % n) * 1000).encode()
+    framing = n % 3
+    if framing == 0:
+        return b'HTTP/1.1 200 OK\r\nContent-Length: %d\r\n\r\n' % len(body) + body, False
+    if framing == 1:
+        out = b'HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n'
+        for i in range(0, len(body), 777):
+            chunk = body[i:i + 777]
+            out += b'%x\r\n' % len(chunk) + chunk + b'\r\n'
+        return out + b'0\r\n\r\n', False
+    return b'HTTP/1.1 200 OK\r\nConnection: close\r\n\r\n' + body, True
+
+
+def handle(conn):
+    requests = conn.makefile('rb')
+    try:
+        while True:
+            request_line = requests.readline()
+            if not request_line:
+                return
+            path = request_line.split()[1].decode().strip('/')
+            while requests.readline() not in (b'\r\n', b''):
+                pass
+            time.sleep(0.2 + random.random() * 0.3)
+            n = int(path.split('.')[0]) if path[:1].isdigit() else 0
+            out, close = response(n)
+            conn.sendall(out)
+            if close:
+                return
+    except OSError:
+        pass
+    finally:
+        conn.close()
+
+
+def main():
+    port = int(sys.argv[1]) if len(sys.argv) > 1 else 18080
+    server = socket.socket()
+    server.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    server.bind(('127.0.0.1', port))
+    server.listen(512)
+    print('listening on 127.0.0.1:%d' % port, flush=True)
+    while True:
+        conn, _ = server.accept()
+        threading.Thread(target=handle, args=(conn,), daemon=True).start()
+
+
+if __name__ == '__main__':
+    main()
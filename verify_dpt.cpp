@@ -0,0 +1,225 @@
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstdint>
+#include "dpt_definitions.hpp"
+#include "dpt_reference_engine.hpp"
+#include "dpt_thread_statistics.hpp"
+#include <optional>
+#include <ostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <utility>
+#include "verify_dpt.hpp"
+#include <vector>
+
+namespace {
+constexpr std::array<std::string_view, 6> counter_names = {
+    "language_mentions", "meme_posts", "topic_discussions", "insults", "programming_jokes", "buzzwords"
+};
+static_assert(counter_names.size() == dpt::statistics_counters.size());
+
+/// random posts made of definition tokens in every casing, the separators the policies look for,
+/// 4chan markup and filler, some of them mutated byte by byte afterwards
+class post_generator {
+public:
+    post_generator(const dpt::definitions& defs, std::uint64_t seed) : random{seed}, tokens{} {
+        for (const auto* values : {&defs.programming_languages, &defs.memes, &defs.topics, &defs.insults, &defs.programming_jokes, &defs.buzzwords}) {
+            for (const auto& val : *values) {
+                tokens.insert(tokens.end(), val.tokens.begin(), val.tokens.end());
+                tokens.insert(tokens.end(), val.occurs_in.begin(), val.occurs_in.end());
+            }
+        }
+        tokens.insert(tokens.end(), {"the", "a", "is", "in", "this", "just", "for", "first", "code", "op", "anon", "fag", "s", "wtf", "lol"});
+    }
+
+    std::string next() {
+        std::string post;
+        if (chance(10)) {
+            // a post that is nothing but a token, the single word memes only count these
+            post = pad(cased(pick(tokens)));
+        } else {
+            const std::size_t n_pieces = uniform(0, 30);
+            for (std::size_t i = 0; i < n_pieces; ++i) {
+                post += separator();
+                post += piece();
+            }
+            post += separator();
+        }
+        if (chance(3)) {
+            mutate(post);
+        }
+        return post;
+    }
+private:
+    std::size_t uniform(std::size_t min, std::size_t max) {
+        return std::uniform_int_distribution<std::size_t>{min, max}(random);
+    }
+    bool chance(std::size_t one_in) {
+        return uniform(1, one_in) == 1;
+    }
+    template <typename Container> typename Container::value_type pick(const Container& c) {
+        return c[uniform(0, c.size() - 1)];
+    }
+    std::string cased(std::string token) {
+        switch (uniform(0, 3)) {
+        case 0:
+            std::transform(token.begin(), token.end(), token.begin(), [](char c){ return std::toupper(c); });
+            break;
+        case 1:
+            if (!token.empty()) {
+                token[0] = std::toupper(token[0]);
+            }
+            break;
+        case 2:
+            for (auto& c : token) {
+                c = chance(2) ? std::toupper(c) : std::tolower(c);
+            }
+            break;
+        default:
+            break;
+        }
+        return token;
+    }
+    std::string pad(std::string str) {
+        static constexpr std::array<std::string_view, 5> padding = {"", " ", "  ", "<br>", "."};
+        return std::string(pick(padding)) + str + std::string(pick(padding));
+    }
+    std::string separator() {
+        static constexpr std::array<std::string_view, 16> separators = {
+            " ", " ", " ", "  ", "", "(", ")", "-", ",", ".", "?", "!", "\"", "s ", "fag ", "<br>"
+        };
+        return std::string(pick(separators));
+    }
+    std::string piece() {
+        static constexpr std::array<std::string_view, 12> markup = {
+            "<a href=\"#p123456\" class=\"quotelink\">&gt;&gt;123456</a>",
+            "<a href=\"#p123456\" class=\"quotelink\">&gt;&gt;123456 (OP)</a>",
+            "<a href=\"/g/thread/1#p2\" class=\"quotelink\">&gt;&gt;&gt;/g/2</a>",
+            "<a href=\"#p1",
+            "</a>",
+            "<span class=\"quote\">&gt;",
+            "</span>",
+            "<pre class=\"prettyprint\">int main() {}</pre>",
+            "&#039;",
+            "&quot;",
+            "&gt;",
+            "&amp;"
+        };
+        switch (uniform(0, 9)) {
+        case 0:
+            return std::string(pick(markup));
+        case 1: {
+            std::string punctuation(uniform(1, 3), ' ');
+            for (auto& c : punctuation) {
+                c = pick(std::string_view{"!\"#$%&'()*+,-./:;<=>?@[\\]^_`{|}~"});
+            }
+            return punctuation;
+        }
+        case 2:
+            // two tokens glued together, e.g. javascript inside java or fizzbuzz
+            return cased(pick(tokens)) + cased(pick(tokens));
+        default:
+            return cased(pick(tokens));
+        }
+    }
+    void mutate(std::string& post) {
+        for (std::size_t n_mutations = uniform(1, 4); (n_mutations > 0) && !post.empty(); --n_mutations) {
+            const std::size_t p = uniform(0, post.size() - 1);
+            switch (uniform(0, 4)) {
+            case 0:
+                post[p] = static_cast<char>(uniform(1, 255));
+                break;
+            case 1:
+                post.insert(p, 1, pick(std::string_view{" +-*#.,()\"s"}));
+                break;
+            case 2:
+                post.erase(p, uniform(1, 8));
+                break;
+            case 3:
+                post.insert(p, post.substr(p, uniform(1, 16)));
+                break;
+            default: {
+                const auto c = static_cast<unsigned char>(post[p]);
+                post[p] = static_cast<char>(std::isupper(c) ? std::tolower(c) : std::toupper(c));
+                break;
+            }
+            }
+        }
+    }
+
+    std::mt19937_64 random;
+    std::vector<std::string> tokens;
+};
+
+struct counter_difference {
+    std::string key;
+    std::size_t reference;
+    std::size_t candidate;
+};
+std::optional<counter_difference> compare_helper(const dpt::statistics& reference, const dpt::statistics& candidate, std::size_t c) {
+    const auto& ref_counter = reference.*dpt::statistics_counters[c];
+    const auto& cand_counter = candidate.*dpt::statistics_counters[c];
+    auto ref_it = ref_counter.begin();
+    auto cand_it = cand_counter.begin();
+    while ((ref_it != ref_counter.end()) || (cand_it != cand_counter.end())) {
+        if ((cand_it == cand_counter.end()) || ((ref_it != ref_counter.end()) && (ref_it->first < cand_it->first))) {
+            return counter_difference{ref_it->first, ref_it->second, 0};
+        }
+        if ((ref_it == ref_counter.end()) || (cand_it->first < ref_it->first)) {
+            return counter_difference{cand_it->first, 0, cand_it->second};
+        }
+        if (ref_it->second != cand_it->second) {
+            return counter_difference{ref_it->first, ref_it->second, cand_it->second};
+        }
+        ++ref_it;
+        ++cand_it;
+    }
+    return std::nullopt;
+}
+std::string post_flags_helper(const dpt::statistics::post& post) {
+    return "quotes=" + std::to_string(post.quotes) + " quotes_op=" + std::to_string(post.quotes_op) + " text=\"" + post.text + "\"";
+}
+} // namespace
+
+namespace dpt {
+std::optional<dpt::divergence> verify(const dpt::definitions& defs, const dpt::statistics::ingest_function& candidate, std::size_t n_posts, std::uint64_t seed) {
+    post_generator generator {defs, seed};
+    for (std::size_t i = 0; i < n_posts; ++i) {
+        const std::string raw_post = generator.next();
+        const auto post = dpt::reference::sanitize(raw_post, "g", i + 1);
+
+        dpt::statistics candidate_sanitized {1, "g", "", ""};
+        candidate_sanitized.add_post(raw_post, i + 1);
+        const auto& candidate_post = candidate_sanitized.posts.back();
+        if ((candidate_post.text != post.text) || (candidate_post.quotes != post.quotes) || (candidate_post.quotes_op != post.quotes_op)) {
+            return dpt::divergence{i, raw_post, post.text, "sanitize", "statistics::add_post", post_flags_helper(post), post_flags_helper(candidate_post)};
+        }
+
+        dpt::statistics reference_stats {1, "g", "", ""};
+        dpt::statistics candidate_stats {1, "g", "", ""};
+        dpt::reference::analyse(reference_stats, post, defs);
+        candidate(candidate_stats, post);
+        for (std::size_t c = 0; c < statistics_counters.size(); ++c) {
+            if (auto diff = compare_helper(reference_stats, candidate_stats, c)) {
+                return dpt::divergence{i, raw_post, post.text, std::string(counter_names[c]), diff->key, std::to_string(diff->reference), std::to_string(diff->candidate)};
+            }
+        }
+        if (reference_stats.n_code_snippets != candidate_stats.n_code_snippets) {
+            return dpt::divergence{i, raw_post, post.text, "n_code_snippets", "class=\"prettyprint\"",
+                                   std::to_string(reference_stats.n_code_snippets), std::to_string(candidate_stats.n_code_snippets)};
+        }
+    }
+    return std::nullopt;
+}
+
+void report(std::ostream& os, const dpt::divergence& d) {
+    os << "Divergence on post " << d.post_index << std::endl
+       << "  raw post  : \"" << d.raw_post << "\"" << std::endl
+       << "  sanitized : \"" << d.text << "\"" << std::endl
+       << "  " << d.counter << " [" << d.key << "]" << std::endl
+       << "  reference : " << d.reference << std::endl
+       << "  candidate : " << d.candidate << std::endl;
+}
+} // namespace dpt
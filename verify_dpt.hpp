@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+#include "dpt_definitions.hpp"
+#include "dpt_thread_statistics.hpp"
+#include <optional>
+#include <ostream>
+#include <string>
+
+namespace dpt {
+/// the first post on which a candidate engine and the reference engine disagree
+struct divergence {
+    std::size_t post_index;
+    std::string raw_post;   // before sanitizing
+    std::string text;       // after sanitizing, as the engines saw it
+    std::string counter;    // "sanitize", a counter of dpt::statistics_counters or "n_code_snippets"
+    std::string key;        // the definition key, or what was compared
+    std::string reference;
+    std::string candidate;
+};
+
+/// generates n_posts posts from the tokens of the definitions, separators, markup and random mutations, and runs
+/// every post through statistics::add_post and the candidate engine as well as through the reference engine.
+/// the same seed always generates the same posts
+std::optional<dpt::divergence> verify(const dpt::definitions& defs, const dpt::statistics::ingest_function& candidate, std::size_t n_posts, std::uint64_t seed);
+void report(std::ostream& os, const dpt::divergence& d);
+} // namespace dpt